@@ -0,0 +1,337 @@
+// Benchmarks slide opening and region reads against a synthetic
+// pyramidal TIFF, or any slide given with --slide.
+//
+//   npm run bench -- [--slide path] [--width 16384] [--height 12288]
+//                    [--tile-size 256] [--region 256] [--iterations 200]
+//                    [--concurrency 1,4,16] [--json]
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var addon = require('bindings')('openslide');
+var tiff = require('./tiff');
+var stats = require('./stats');
+
+function parseArgs(argv) {
+  var options = {
+    slide: null,
+    width: 16384,
+    height: 12288,
+    tileSize: 256,
+    region: 256,
+    iterations: 200,
+    concurrency: [1, 4, 16],
+    json: false
+  };
+  for (var i = 0; i < argv.length; i++) {
+    var arg = argv[i];
+    var value = argv[i + 1];
+    switch (arg) {
+      case '--slide': options.slide = value; i++; break;
+      case '--width': options.width = parseInt(value, 10); i++; break;
+      case '--height': options.height = parseInt(value, 10); i++; break;
+      case '--tile-size': options.tileSize = parseInt(value, 10); i++; break;
+      case '--region': options.region = parseInt(value, 10); i++; break;
+      case '--iterations': options.iterations = parseInt(value, 10); i++; break;
+      case '--concurrency':
+        options.concurrency = value.split(',').map(function(n) { return parseInt(n, 10); });
+        i++;
+        break;
+      case '--json': options.json = true; break;
+      default:
+        throw new Error('Unknown option ' + arg);
+    }
+  }
+  return options;
+}
+
+// Synthetic slides are kept in the temp directory and reused
+function syntheticSlide(options) {
+  var file = path.join(os.tmpdir(), 'openslide-bench-' + options.width + 'x' +
+                       options.height + '-' + options.tileSize + '.tiff');
+  if (!fs.existsSync(file)) {
+    var start = process.hrtime();
+    tiff.writeSyntheticSlide(file + '.tmp', options.width, options.height, options.tileSize);
+    fs.renameSync(file + '.tmp', file);
+    log('generated ' + file + ' in ' + stats.elapsedMs(start).toFixed(0) + ' ms');
+  }
+  return file;
+}
+
+var quiet = false;
+function log(line) {
+  if (!quiet) {
+    console.log(line);
+  }
+}
+
+function formatLatency(summary) {
+  return 'p50 ' + summary.p50.toFixed(2) + ' ms, p90 ' + summary.p90.toFixed(2) +
+         ' ms, p99 ' + summary.p99.toFixed(2) + ' ms, max ' + summary.max.toFixed(2) + ' ms';
+}
+
+function formatBytes(bytes) {
+  return (bytes / (1024 * 1024)).toFixed(1) + ' MB';
+}
+
+// Deterministic region positions spread over level 0
+function regionPositions(slide, size, count) {
+  var seed = 42;
+  function random() {
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+    return seed / 0x7fffffff;
+  }
+  var maxX = Math.max(0, slide.levelWidths[0] - size);
+  var maxY = Math.max(0, slide.levelHeights[0] - size);
+  var positions = [];
+  for (var i = 0; i < count; i++) {
+    positions.push({x: Math.floor(random() * maxX), y: Math.floor(random() * maxY)});
+  }
+  return positions;
+}
+
+function openSlide(file) {
+  var slide = new addon.OpenSlideObject(file);
+  if (!slide.open()) {
+    throw new Error('Cannot open ' + file);
+  }
+  return slide;
+}
+
+// Cold opens go through fresh symlinks, since the registry would
+// otherwise hand back the slide opened before
+function benchOpen(file, options) {
+  var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'openslide-bench-'));
+  var cold = [], warm = [];
+  var count = Math.min(options.iterations, 32);
+  try {
+    for (var i = 0; i < count; i++) {
+      var link = path.join(dir, i + path.extname(file));
+      fs.symlinkSync(path.resolve(file), link);
+      var start = process.hrtime();
+      openSlide(link);
+      cold.push(stats.elapsedMs(start));
+    }
+  } finally {
+    fs.readdirSync(dir).forEach(function(name) { fs.unlinkSync(path.join(dir, name)); });
+    fs.rmdirSync(dir);
+  }
+  addon.clearSlideCache();
+
+  openSlide(file);
+  for (var j = 0; j < options.iterations; j++) {
+    var warmStart = process.hrtime();
+    openSlide(file);
+    warm.push(stats.elapsedMs(warmStart));
+  }
+  return {cold: stats.summarize(cold), warm: stats.summarize(warm)};
+}
+
+function benchSync(slide, positions, options) {
+  var sampler = new stats.MemorySampler();
+  var latencies = [];
+  positions.forEach(function(position) {
+    var start = process.hrtime();
+    slide.readRegion(0, position.x, position.y, options.region, options.region);
+    latencies.push(stats.elapsedMs(start));
+    sampler.sample();
+  });
+  return {latency: stats.summarize(latencies), memory: sampler.stop()};
+}
+
+// Keeps concurrency reads in flight until positions run out
+function benchAsync(slide, positions, options, concurrency, encode, callback) {
+  var sampler = new stats.MemorySampler();
+  var latencies = [];
+  var next = 0, done = 0, failed = null;
+  var start = process.hrtime();
+
+  function issue() {
+    var position = positions[next++];
+    var readStart = process.hrtime();
+    slide.readRegionAsync(0, position.x, position.y, options.region, options.region,
+                          encode, function(err) {
+      latencies.push(stats.elapsedMs(readStart));
+      failed = failed || err;
+      done++;
+      if (next < positions.length) {
+        issue();
+      } else if (done === positions.length) {
+        var seconds = stats.elapsedMs(start) / 1e3;
+        callback(failed, {
+          concurrency: concurrency,
+          tilesPerSecond: positions.length / seconds,
+          latency: stats.summarize(latencies),
+          memory: sampler.stop()
+        });
+      }
+    });
+  }
+
+  for (var i = 0; i < Math.min(concurrency, positions.length); i++) {
+    issue();
+  }
+}
+
+function benchBatch(slide, positions, options, callback) {
+  var batchSize = 16;
+  var regions = positions.map(function(position) {
+    return {level: 0, x: position.x, y: position.y, w: options.region, h: options.region};
+  });
+  var sampler = new stats.MemorySampler();
+  var start = process.hrtime();
+  var offset = 0;
+
+  function nextBatch() {
+    if (offset >= regions.length) {
+      var seconds = stats.elapsedMs(start) / 1e3;
+      callback(null, {tilesPerSecond: regions.length / seconds, memory: sampler.stop()});
+      return;
+    }
+    var batch = regions.slice(offset, offset + batchSize);
+    offset += batchSize;
+    slide.readRegions(batch, function(err) {
+      if (err) {
+        sampler.stop();
+        callback(err);
+        return;
+      }
+      nextBatch();
+    });
+  }
+  nextBatch();
+}
+
+// Runs async steps one after the other
+function series(steps, callback) {
+  var i = 0;
+  function next(err) {
+    if (err || i === steps.length) {
+      callback(err);
+      return;
+    }
+    steps[i++](next);
+  }
+  next();
+}
+
+function nativeStats(file) {
+  var all = addon.getStats();
+  var slide = all.slides.filter(function(s) { return s.fileName === file; })[0];
+  var result = {tileCache: all.tileCache, operations: {}, decode: null};
+  if (!slide) {
+    return result;
+  }
+  Object.keys(slide.operations).forEach(function(name) {
+    var op = slide.operations[name];
+    if (op.calls === 0) {
+      return;
+    }
+    result.operations[name] = {
+      calls: op.calls,
+      errors: op.errors,
+      bytes: op.bytes,
+      meanMs: op.latency.totalMicros / op.calls / 1e3,
+      p99Ms: stats.histogramPercentile(op.latency.histogram, 99)
+    };
+  });
+  result.decode = {
+    calls: slide.decode.calls,
+    pixels: slide.decode.pixels,
+    meanMs: slide.decode.calls ? slide.decode.latency.totalMicros / slide.decode.calls / 1e3 : 0,
+    p50Ms: stats.histogramPercentile(slide.decode.latency.histogram, 50),
+    p99Ms: stats.histogramPercentile(slide.decode.latency.histogram, 99)
+  };
+  return result;
+}
+
+function main() {
+  var options = parseArgs(process.argv.slice(2));
+  quiet = options.json;
+  var file = options.slide || syntheticSlide(options);
+  var report = {slide: file, options: options, startRss: process.memoryUsage().rss};
+
+  report.open = benchOpen(file, options);
+  log('open cold: ' + formatLatency(report.open.cold));
+  log('open warm: ' + formatLatency(report.open.warm));
+
+  var slide = openSlide(file);
+  log('slide: ' + slide.levelWidths[0] + ' x ' + slide.levelHeights[0] + ', ' +
+      slide.levelCount + ' levels');
+  var positions = regionPositions(slide, options.region, options.iterations);
+  addon.resetStats();
+
+  // Decode cost without the native tile cache
+  addon.configureTileCache({maxBytes: 0});
+  addon.clearTileCache();
+  report.readRegion = benchSync(slide, positions, options);
+  log('readRegion ' + options.region + 'px uncached: ' + formatLatency(report.readRegion.latency) +
+      ', peak rss ' + formatBytes(report.readRegion.memory.peakRss));
+
+  addon.configureTileCache({maxBytes: 128 * 1024 * 1024, cacheRaw: true});
+  benchSync(slide, positions, options);
+  report.readRegionCached = benchSync(slide, positions, options);
+  log('readRegion ' + options.region + 'px cached:   ' +
+      formatLatency(report.readRegionCached.latency) +
+      ', peak rss ' + formatBytes(report.readRegionCached.memory.peakRss));
+  addon.configureTileCache({maxBytes: 0, cacheRaw: false});
+
+  report.async = [];
+  var steps = [];
+  [{format: 'raw'}, {format: 'jpeg', quality: 80}].forEach(function(encode) {
+    options.concurrency.forEach(function(concurrency) {
+      steps.push(function(next) {
+        benchAsync(slide, positions, options, concurrency, encode, function(err, result) {
+          if (err) {
+            next(err);
+            return;
+          }
+          result.format = encode.format;
+          report.async.push(result);
+          log('readRegionAsync ' + encode.format + ' x' + concurrency + ': ' +
+              result.tilesPerSecond.toFixed(0) + ' tiles/s, ' + formatLatency(result.latency) +
+              ', peak rss ' + formatBytes(result.memory.peakRss));
+          next();
+        });
+      });
+    });
+  });
+  steps.push(function(next) {
+    benchBatch(slide, positions, options, function(err, result) {
+      if (err) {
+        next(err);
+        return;
+      }
+      report.readRegions = result;
+      log('readRegions x16: ' + result.tilesPerSecond.toFixed(0) + ' tiles/s');
+      next();
+    });
+  });
+
+  series(steps, function(err) {
+    if (err) {
+      console.error(err);
+      process.exit(1);
+    }
+    report.native = nativeStats(file);
+    report.endRss = process.memoryUsage().rss;
+    if (options.json) {
+      console.log(JSON.stringify(report, null, 2));
+      return;
+    }
+    Object.keys(report.native.operations).forEach(function(name) {
+      var op = report.native.operations[name];
+      log('native ' + name + ': ' + op.calls + ' calls, ' + op.errors + ' errors, ' +
+          formatBytes(op.bytes) + ', mean ' + op.meanMs.toFixed(2) + ' ms, p99 <= ' +
+          op.p99Ms.toFixed(2) + ' ms');
+    });
+    var decode = report.native.decode;
+    if (decode) {
+      log('native decode: ' + decode.calls + ' calls, ' + (decode.pixels / 1e6).toFixed(1) +
+          ' Mpx, mean ' + decode.meanMs.toFixed(2) + ' ms, p50 <= ' + decode.p50Ms.toFixed(2) +
+          ' ms, p99 <= ' + decode.p99Ms.toFixed(2) + ' ms');
+    }
+    log('rss: start ' + formatBytes(report.startRss) + ', end ' + formatBytes(report.endRss));
+  });
+}
+
+main();
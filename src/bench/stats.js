@@ -0,0 +1,74 @@
+// Latency summaries for the benchmark report
+
+function elapsedMs(start) {
+  var diff = process.hrtime(start);
+  return diff[0] * 1e3 + diff[1] / 1e6;
+}
+
+// Nearest-rank percentile of an ascending array
+function percentile(sorted, p) {
+  if (sorted.length === 0) {
+    return 0;
+  }
+  var rank = Math.ceil(p / 100 * sorted.length);
+  return sorted[Math.min(sorted.length, Math.max(1, rank)) - 1];
+}
+
+function summarize(samples) {
+  var sorted = samples.slice().sort(function(a, b) { return a - b; });
+  var total = sorted.reduce(function(sum, value) { return sum + value; }, 0);
+  return {
+    count: sorted.length,
+    mean: sorted.length ? total / sorted.length : 0,
+    p50: percentile(sorted, 50),
+    p90: percentile(sorted, 90),
+    p99: percentile(sorted, 99),
+    max: sorted.length ? sorted[sorted.length - 1] : 0
+  };
+}
+
+// Upper bound, in ms, of the bucket holding the p-th percentile of a
+// native histogram, where bucket i counts [2^i, 2^(i+1)) microseconds
+function histogramPercentile(histogram, p) {
+  var count = histogram.reduce(function(sum, value) { return sum + value; }, 0);
+  if (count === 0) {
+    return 0;
+  }
+  var rank = Math.ceil(p / 100 * count);
+  var seen = 0;
+  for (var i = 0; i < histogram.length; i++) {
+    seen += histogram[i];
+    if (seen >= rank) {
+      return Math.pow(2, i + 1) / 1e3;
+    }
+  }
+  return Math.pow(2, histogram.length) / 1e3;
+}
+
+// Tracks peak memory while a phase runs
+function MemorySampler(intervalMs) {
+  this.peakRss = 0;
+  this.peakExternal = 0;
+  this.sample();
+  this._timer = setInterval(this.sample.bind(this), intervalMs || 20);
+}
+
+MemorySampler.prototype.sample = function() {
+  var usage = process.memoryUsage();
+  this.peakRss = Math.max(this.peakRss, usage.rss);
+  this.peakExternal = Math.max(this.peakExternal, usage.external || 0);
+};
+
+MemorySampler.prototype.stop = function() {
+  this.sample();
+  clearInterval(this._timer);
+  return {peakRss: this.peakRss, peakExternal: this.peakExternal};
+};
+
+module.exports = {
+  elapsedMs: elapsedMs,
+  percentile: percentile,
+  summarize: summarize,
+  histogramPercentile: histogramPercentile,
+  MemorySampler: MemorySampler
+};
@@ -0,0 +1,188 @@
+// Writes synthetic pyramidal tiled TIFFs that openslide opens with its
+// generic-tiff driver: one deflate-compressed RGB directory per level,
+// each half the size of the previous one, down to a single tile.
+var fs = require('fs');
+var zlib = require('zlib');
+
+// Distinct tile images per level; tiles repeat these so generation stays
+// fast while every tile is still decoded on its own
+var VARIANTS = 32;
+
+var TAG_NEW_SUBFILE_TYPE = 254;
+var TAG_IMAGE_WIDTH = 256;
+var TAG_IMAGE_LENGTH = 257;
+var TAG_BITS_PER_SAMPLE = 258;
+var TAG_COMPRESSION = 259;
+var TAG_PHOTOMETRIC = 262;
+var TAG_SAMPLES_PER_PIXEL = 277;
+var TAG_PLANAR_CONFIG = 284;
+var TAG_TILE_WIDTH = 322;
+var TAG_TILE_LENGTH = 323;
+var TAG_TILE_OFFSETS = 324;
+var TAG_TILE_BYTE_COUNTS = 325;
+
+var TYPE_SHORT = 3;
+var TYPE_LONG = 4;
+
+var COMPRESSION_DEFLATE = 8;
+var PHOTOMETRIC_RGB = 2;
+
+// Smooth stained-looking blobs plus per-pixel noise, so tiles neither
+// compress to nothing nor look like pure noise
+function renderTile(tileSize, variant, level) {
+  var pixels = Buffer.alloc(tileSize * tileSize * 3);
+  var seed = variant * 7919 + level * 104729 + 1;
+  function random() {
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+    return seed / 0x7fffffff;
+  }
+  var cx = random() * tileSize, cy = random() * tileSize;
+  var radius = tileSize * (0.3 + random() * 0.5);
+  var tissue = random() < 0.8;
+  var i = 0;
+  for (var y = 0; y < tileSize; y++) {
+    for (var x = 0; x < tileSize; x++) {
+      var dx = x - cx, dy = y - cy;
+      var inside = tissue && dx * dx + dy * dy < radius * radius;
+      var noise = (random() * 24) | 0;
+      if (inside) {
+        pixels[i++] = 180 + noise;
+        pixels[i++] = 90 + noise;
+        pixels[i++] = 160 + noise;
+      } else {
+        pixels[i++] = 230 + (noise >> 2);
+        pixels[i++] = 230 + (noise >> 2);
+        pixels[i++] = 232 + (noise >> 2);
+      }
+    }
+  }
+  return zlib.deflateSync(pixels, {level: 1});
+}
+
+function levelSizes(width, height, tileSize) {
+  var levels = [];
+  var w = width, h = height;
+  for (;;) {
+    levels.push({width: w, height: h});
+    if (w <= tileSize && h <= tileSize) {
+      return levels;
+    }
+    w = Math.max(1, Math.ceil(w / 2));
+    h = Math.max(1, Math.ceil(h / 2));
+  }
+}
+
+// Classic TIFF offsets are 32 bits wide
+function checkOffset(offset) {
+  if (offset > 0xffffffff) {
+    throw new Error('Synthetic slide exceeds 4 GB, use a smaller size');
+  }
+}
+
+function writeAt(fd, buffer, position) {
+  fs.writeSync(fd, buffer, 0, buffer.length, position);
+}
+
+// entries: [tag, type, values]; values longer than 4 bytes go to the
+// end of the IFD. Returns the IFD and the position of its next pointer.
+function buildIfd(entries, ifdOffset) {
+  entries.sort(function(a, b) { return a[0] - b[0]; });
+  var headerSize = 2 + entries.length * 12 + 4;
+  var extraSize = 0;
+  entries.forEach(function(entry) {
+    var size = entry[2].length * (entry[1] === TYPE_SHORT ? 2 : 4);
+    if (size > 4) {
+      extraSize += size;
+    }
+  });
+
+  var ifd = Buffer.alloc(headerSize + extraSize);
+  var extra = headerSize;
+  ifd.writeUInt16LE(entries.length, 0);
+  entries.forEach(function(entry, n) {
+    var tag = entry[0], type = entry[1], values = entry[2];
+    var itemSize = type === TYPE_SHORT ? 2 : 4;
+    var pos = 2 + n * 12;
+    ifd.writeUInt16LE(tag, pos);
+    ifd.writeUInt16LE(type, pos + 2);
+    ifd.writeUInt32LE(values.length, pos + 4);
+    var valuePos = pos + 8;
+    if (values.length * itemSize > 4) {
+      ifd.writeUInt32LE(ifdOffset + extra, pos + 8);
+      valuePos = extra;
+      extra += values.length * itemSize;
+    }
+    values.forEach(function(value, k) {
+      if (type === TYPE_SHORT) {
+        ifd.writeUInt16LE(value, valuePos + k * 2);
+      } else {
+        ifd.writeUInt32LE(value, valuePos + k * 4);
+      }
+    });
+  });
+  return {data: ifd, nextPointer: ifdOffset + headerSize - 4};
+}
+
+// Writes a width x height slide with square tiles to path
+function writeSyntheticSlide(path, width, height, tileSize) {
+  var fd = fs.openSync(path, 'w');
+  var header = Buffer.alloc(8);
+  header.write('II', 0, 'ascii');
+  header.writeUInt16LE(42, 2);
+  writeAt(fd, header, 0);
+
+  var position = 8;
+  var nextPointer = 4;
+  levelSizes(width, height, tileSize).forEach(function(level, l) {
+    var variants = [];
+    for (var v = 0; v < VARIANTS; v++) {
+      variants.push(renderTile(tileSize, v, l));
+    }
+
+    var cols = Math.ceil(level.width / tileSize);
+    var rows = Math.ceil(level.height / tileSize);
+    var offsets = [], counts = [];
+    for (var row = 0; row < rows; row++) {
+      for (var col = 0; col < cols; col++) {
+        var tile = variants[(col * 31 + row * 17) % VARIANTS];
+        checkOffset(position + tile.length);
+        writeAt(fd, tile, position);
+        offsets.push(position);
+        counts.push(tile.length);
+        position += tile.length;
+      }
+    }
+
+    // IFDs start on a word boundary
+    position += position & 1;
+    var ifd = buildIfd([
+      [TAG_NEW_SUBFILE_TYPE, TYPE_LONG, [l === 0 ? 0 : 1]],
+      [TAG_IMAGE_WIDTH, TYPE_LONG, [level.width]],
+      [TAG_IMAGE_LENGTH, TYPE_LONG, [level.height]],
+      [TAG_BITS_PER_SAMPLE, TYPE_SHORT, [8, 8, 8]],
+      [TAG_COMPRESSION, TYPE_SHORT, [COMPRESSION_DEFLATE]],
+      [TAG_PHOTOMETRIC, TYPE_SHORT, [PHOTOMETRIC_RGB]],
+      [TAG_SAMPLES_PER_PIXEL, TYPE_SHORT, [3]],
+      [TAG_PLANAR_CONFIG, TYPE_SHORT, [1]],
+      [TAG_TILE_WIDTH, TYPE_LONG, [tileSize]],
+      [TAG_TILE_LENGTH, TYPE_LONG, [tileSize]],
+      [TAG_TILE_OFFSETS, TYPE_LONG, offsets],
+      [TAG_TILE_BYTE_COUNTS, TYPE_LONG, counts]
+    ], position);
+    checkOffset(position + ifd.data.length);
+    writeAt(fd, ifd.data, position);
+
+    var pointer = Buffer.alloc(4);
+    pointer.writeUInt32LE(position, 0);
+    writeAt(fd, pointer, nextPointer);
+    nextPointer = ifd.nextPointer;
+    position += ifd.data.length;
+  });
+
+  fs.closeSync(fd);
+}
+
+module.exports = {
+  levelSizes: levelSizes,
+  writeSyntheticSlide: writeSyntheticSlide
+};
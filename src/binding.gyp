@@ -2,13 +2,35 @@
   "targets": [
     {
       "target_name": "openslide",
-      "sources": [ "openslide.cc", "openslideobject.cc" ],
+      "sources": [ "openslide.cc", "openslideobject.cc", "readregionworker.cc",
+                   "bufferpool.cc", "handlepool.cc", "regionreader.cc",
+                   "slide.cc", "slideregistry.cc", "readregionsworker.cc",
+                   "encoder.cc", "pixelconvert.cc", "encodeoptions.cc",
+                   "resample.cc", "deepzoom.cc", "deepzoomgenerator.cc",
+                   "deepzoomworker.cc", "tilecache.cc", "thumbnail.cc",
+                   "slideimageworker.cc", "slidestats.cc",
+                   "encodedresult.cc", "parallel.cc" ],
       "include_dirs": [
-        "<!(node -e \"require('nan')\")",
-	"/usr/local/include"
+        "<!(node -e \"require('nan')\")"
       ],
-      "libraries":[
-        "/usr/local/Cellar/openslide/3.4.1_2/lib/libopenslide.dylib"
+      "conditions": [
+        [ "OS=='mac'", {
+          "include_dirs": [ "/usr/local/include" ],
+          "libraries":[
+            "/usr/local/Cellar/openslide/3.4.1_2/lib/libopenslide.dylib",
+            "-L/usr/local/lib",
+            "-ljpeg",
+            "-lpng"
+          ]
+        }],
+        [ "OS=='linux'", {
+          # Sources include <openslide/openslide.h>, relative to includedir
+          "include_dirs": [ "<!@(pkg-config --variable=includedir openslide)" ],
+          "libraries": [
+            "<!@(pkg-config --libs openslide libpng)",
+            "-ljpeg"
+          ]
+        }]
       ]
     }
   ]
@@ -0,0 +1,61 @@
+#include "bufferpool.h"
+#include <stdlib.h>
+
+static const size_t DATA_SIZE = 256 * 256 * 4;
+
+BufferPool tilePool(DATA_SIZE, 64);
+
+BufferPool::BufferPool(size_t blockSize, size_t maxFreeBlocks)
+  : _blockSize(blockSize), _maxFreeBlocks(maxFreeBlocks) {
+}
+
+BufferPool::~BufferPool() {
+  for (size_t i = 0; i < _free.size(); i++) {
+    free(_free[i]);
+  }
+}
+
+char *BufferPool::Acquire(size_t size) {
+  if (size != _blockSize) {
+    return (char *)malloc(size);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_free.empty()) {
+      char *data = _free.back();
+      _free.pop_back();
+      return data;
+    }
+  }
+  return (char *)malloc(_blockSize);
+}
+
+void BufferPool::Release(char *data, size_t size) {
+  if (data == NULL) {
+    return;
+  }
+  if (size == _blockSize) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_free.size() < _maxFreeBlocks) {
+      _free.push_back(data);
+      return;
+    }
+  }
+  free(data);
+}
+
+Nan::MaybeLocal<v8::Object> BufferPool::NewBuffer(char *data, size_t size) {
+  // Other sizes were malloc'ed directly, flag them with a NULL hint
+  void *hint = size == _blockSize ? this : NULL;
+  return Nan::NewBuffer(data,size,FreeCallback,hint);
+}
+
+void BufferPool::FreeCallback(char *data, void *hint) {
+  if (hint == NULL) {
+    free(data);
+    return;
+  }
+  BufferPool *pool = static_cast<BufferPool *>(hint);
+  pool->Release(data,pool->_blockSize);
+}
@@ -0,0 +1,36 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <nan.h>
+#include <mutex>
+#include <vector>
+
+// Recycles fixed-size native pixel buffers. Blocks are handed to JS
+// through Nan::NewBuffer and come back here from the Buffer's free
+// callback, so tile reads neither copy nor churn the allocator.
+// Only requests of exactly the block size are pooled; any other size is
+// malloc'ed to fit, so a Buffer never pins more memory than V8 is told
+// about.
+class BufferPool {
+    public:
+        BufferPool(size_t blockSize, size_t maxFreeBlocks);
+        ~BufferPool();
+        // Safe to call from any thread
+        char *Acquire(size_t size);
+        void Release(char *data, size_t size);
+        // Wraps memory from Acquire in a Buffer that releases it on GC.
+        // Must be called on the main thread.
+        Nan::MaybeLocal<v8::Object> NewBuffer(char *data, size_t size);
+        size_t BlockSize() const { return _blockSize; }
+    private:
+        static void FreeCallback(char *data, void *hint);
+        size_t _blockSize;
+        size_t _maxFreeBlocks;
+        std::mutex _mutex;
+        std::vector<char *> _free;
+};
+
+// Shared by every slide; blocks hold one 256x256 ARGB tile
+extern BufferPool tilePool;
+
+#endif
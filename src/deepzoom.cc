@@ -0,0 +1,256 @@
+#include "deepzoom.h"
+#include "parallel.h"
+#include "regionreader.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+const char *ImageFormatName(ImageFormat format) {
+  switch (format) {
+    case FORMAT_JPEG:
+      return "jpeg";
+    case FORMAT_PNG:
+      return "png";
+    default:
+      return "raw";
+  }
+}
+
+static int64_t GetIntProperty(const Slide &slide, const char *name, int64_t fallback) {
+  std::map<std::string,std::string>::const_iterator it = slide.properties.find(name);
+  if (it == slide.properties.end() || it->second.empty()) {
+    return fallback;
+  }
+  return strtoll(it->second.c_str(), NULL, 10);
+}
+
+DeepZoom::DeepZoom(std::shared_ptr<Slide> slide, int tileSize, int overlap, bool limitBounds)
+  : _slide(slide), _tileSize(tileSize), _overlap(overlap), _limitBounds(limitBounds),
+    _l0OffsetX(0), _l0OffsetY(0) {
+  int64_t l0W = slide->levelWidths[0];
+  int64_t l0H = slide->levelHeights[0];
+  double scaleW = 1.0;
+  double scaleH = 1.0;
+  if (limitBounds) {
+    _l0OffsetX = GetIntProperty(*slide, "openslide.bounds-x", 0);
+    _l0OffsetY = GetIntProperty(*slide, "openslide.bounds-y", 0);
+    scaleW = (double)GetIntProperty(*slide, "openslide.bounds-width", l0W) / l0W;
+    scaleH = (double)GetIntProperty(*slide, "openslide.bounds-height", l0H) / l0H;
+  }
+  for (int32_t i = 0; i < slide->levelCount; i++) {
+    _lDimensions.push_back(std::make_pair((int64_t)ceil(slide->levelWidths[i] * scaleW),
+                                          (int64_t)ceil(slide->levelHeights[i] * scaleH)));
+  }
+
+  // Halve down to a single pixel, then order from smallest to largest
+  std::pair<int64_t,int64_t> zSize = _lDimensions[0];
+  _zDimensions.push_back(zSize);
+  while (zSize.first > 1 || zSize.second > 1) {
+    zSize.first = std::max((int64_t)1, (zSize.first + 1) / 2);
+    zSize.second = std::max((int64_t)1, (zSize.second + 1) / 2);
+    _zDimensions.insert(_zDimensions.begin(), zSize);
+  }
+
+  for (size_t i = 0; i < _zDimensions.size(); i++) {
+    _tDimensions.push_back(std::make_pair((_zDimensions[i].first + tileSize - 1) / tileSize,
+                                          (_zDimensions[i].second + tileSize - 1) / tileSize));
+    double downsample = ldexp(1.0, (int)(_zDimensions.size() - i - 1));
+    int32_t slideLevel = slide->BestLevelForDownsample(downsample);
+    _slideLevels.push_back(slideLevel);
+    _lzDownsamples.push_back(downsample / slide->levelDownsamples[slideLevel]);
+  }
+}
+
+std::string DeepZoom::Dzi(const std::string &format) const {
+  std::ostringstream xml;
+  xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\""
+      << " Format=\"" << format << "\""
+      << " Overlap=\"" << _overlap << "\""
+      << " TileSize=\"" << _tileSize << "\">"
+      << "<Size Height=\"" << _zDimensions.back().second << "\""
+      << " Width=\"" << _zDimensions.back().first << "\"/>"
+      << "</Image>\n";
+  return xml.str();
+}
+
+bool DeepZoom::GetTileInfo(int level, int64_t col, int64_t row, TileInfo *info) const {
+  if (level < 0 || level >= LevelCount()) {
+    return false;
+  }
+  int64_t cols = _tDimensions[level].first;
+  int64_t rows = _tDimensions[level].second;
+  if (col < 0 || col >= cols || row < 0 || row >= rows) {
+    return false;
+  }
+
+  int32_t slideLevel = _slideLevels[level];
+  double lzDownsample = _lzDownsamples[level];
+  double levelDownsample = _slide->levelDownsamples[slideLevel];
+
+  // Overlap only on sides that have a neighbouring tile
+  int64_t zOverlapLeft = col != 0 ? _overlap : 0;
+  int64_t zOverlapTop = row != 0 ? _overlap : 0;
+  int64_t zOverlapRight = col != cols - 1 ? _overlap : 0;
+  int64_t zOverlapBottom = row != rows - 1 ? _overlap : 0;
+
+  info->slideLevel = slideLevel;
+  info->zW = std::min((int64_t)_tileSize, _zDimensions[level].first - _tileSize * col) +
+             zOverlapLeft + zOverlapRight;
+  info->zH = std::min((int64_t)_tileSize, _zDimensions[level].second - _tileSize * row) +
+             zOverlapTop + zOverlapBottom;
+
+  double lX = lzDownsample * (_tileSize * col - zOverlapLeft);
+  double lY = lzDownsample * (_tileSize * row - zOverlapTop);
+  info->l0X = (int64_t)(levelDownsample * lX) + _l0OffsetX;
+  info->l0Y = (int64_t)(levelDownsample * lY) + _l0OffsetY;
+  info->lW = std::min((int64_t)ceil(lzDownsample * info->zW),
+                      _lDimensions[slideLevel].first - (int64_t)ceil(lX));
+  info->lH = std::min((int64_t)ceil(lzDownsample * info->zH),
+                      _lDimensions[slideLevel].second - (int64_t)ceil(lY));
+  info->lW = std::max(info->lW, (int64_t)1);
+  info->lH = std::max(info->lH, (int64_t)1);
+  return true;
+}
+
+bool DeepZoom::GetTileSize(int level, int64_t col, int64_t row, int64_t *w, int64_t *h) const {
+  TileInfo info;
+  if (!GetTileInfo(level, col, row, &info)) {
+    return false;
+  }
+  *w = info.zW;
+  *h = info.zH;
+  return true;
+}
+
+bool DeepZoom::ReadTile(int level, int64_t col, int64_t row, uint32_t *dest,
+                        std::string *error) const {
+  TileInfo info;
+  if (!GetTileInfo(level, col, row, &info)) {
+    *error = "Invalid tile address";
+    return false;
+  }
+
+  if (info.lW == info.zW && info.lH == info.zH) {
+    return ReadRegionTiled(_slide.get(), dest, info.l0X, info.l0Y, info.slideLevel,
+                           info.lW, info.lH, error);
+  }
+
+  // With few slide levels the source can be far larger than the tile
+  return ReadRegionScaled(_slide.get(), dest, info.l0X, info.l0Y, info.slideLevel,
+                          info.lW, info.lH, info.zW, info.zH, error);
+}
+
+static bool MakeDirectory(const std::string &path, std::string *error) {
+  if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+    *error = "Cannot create directory " + path;
+    return false;
+  }
+  return true;
+}
+
+static bool WriteFile(const std::string &path, const char *data, size_t size,
+                      std::string *error) {
+  FILE *file = fopen(path.c_str(), "wb");
+  if (file == NULL) {
+    *error = "Cannot write " + path;
+    return false;
+  }
+  bool written = fwrite(data, 1, size, file) == size;
+  if (fclose(file) != 0 || !written) {
+    *error = "Cannot write " + path;
+    return false;
+  }
+  return true;
+}
+
+// Renders, encodes and writes one tile per call. Tiles of all levels
+// are numbered consecutively, starting at levelStart[level].
+struct ExportTile {
+  const DeepZoom *deepZoom;
+  const EncodeOptions *options;
+  std::string directory;
+  std::vector<int64_t> levelStart;
+  std::atomic<bool> *failed;
+  std::mutex *errorMutex;
+  std::string *error;
+
+  void operator()(size_t index) {
+    if (*failed) {
+      return;
+    }
+    int level = (int)(std::upper_bound(levelStart.begin(), levelStart.end(), (int64_t)index) -
+                      levelStart.begin()) - 1;
+    int64_t tile = index - levelStart[level];
+    int64_t col = tile % deepZoom->LevelColumns(level);
+    int64_t row = tile / deepZoom->LevelColumns(level);
+
+    int64_t w = 0, h = 0;
+    deepZoom->GetTileSize(level, col, row, &w, &h);
+    std::vector<uint32_t> pixels(w * h);
+    std::string tileError;
+    char *data = NULL;
+    size_t size = 0;
+    std::ostringstream path;
+    path << directory << "/" << level << "/" << col << "_" << row << "."
+         << ImageFormatName(options->format);
+    bool ok = deepZoom->ReadTile(level, col, row, &pixels[0], &tileError) &&
+              EncodeImage(&pixels[0], w, h, *options, &data, &size, &tileError) &&
+              WriteFile(path.str(), data, size, &tileError);
+    free(data);
+    if (!ok) {
+      std::lock_guard<std::mutex> lock(*errorMutex);
+      if (!*failed) {
+        *error = tileError;
+        *failed = true;
+      }
+    }
+  }
+};
+
+bool DeepZoom::ExportPyramid(const std::string &basename, const EncodeOptions &options,
+                             size_t threads, std::string *error) const {
+  std::string format = ImageFormatName(options.format);
+  std::string dzi = Dzi(format);
+  if (!WriteFile(basename + ".dzi", dzi.data(), dzi.size(), error)) {
+    return false;
+  }
+
+  std::atomic<bool> failed(false);
+  std::mutex errorMutex;
+  ExportTile exportTile;
+  exportTile.deepZoom = this;
+  exportTile.options = &options;
+  exportTile.directory = basename + "_files";
+  exportTile.failed = &failed;
+  exportTile.errorMutex = &errorMutex;
+  exportTile.error = error;
+
+  if (!MakeDirectory(exportTile.directory, error)) {
+    return false;
+  }
+  int64_t tileCount = 0;
+  for (int level = 0; level < LevelCount(); level++) {
+    std::ostringstream levelDirectory;
+    levelDirectory << exportTile.directory << "/" << level;
+    if (!MakeDirectory(levelDirectory.str(), error)) {
+      return false;
+    }
+    exportTile.levelStart.push_back(tileCount);
+    tileCount += LevelColumns(level) * LevelRows(level);
+  }
+
+  // Decoding is bounded by the slide's handles and encoding by the
+  // cores, more threads than that would only contend
+  size_t cores = std::thread::hardware_concurrency();
+  threads = std::min(threads, std::max(MaxThreads(), cores));
+  ParallelFor((size_t)tileCount, threads, exportTile);
+  return !failed;
+}
@@ -0,0 +1,78 @@
+#ifndef DEEPZOOM_H
+#define DEEPZOOM_H
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "encoder.h"
+#include "slide.h"
+
+// Deep Zoom tiling of a slide, following openslide-python's
+// DeepZoomGenerator: Deep Zoom level n is half the size of level n + 1,
+// the last being the full slide (or its bounds with limitBounds). Each
+// tile is read from the slide level best suited to its downsample and
+// scaled the rest of the way with an area filter.
+// Largest tileSize accepted; overlap may not exceed tileSize
+static const int MAX_DEEPZOOM_TILE_SIZE = 4096;
+
+class DeepZoom {
+    public:
+        DeepZoom(std::shared_ptr<Slide> slide, int tileSize, int overlap, bool limitBounds);
+        int LevelCount() const { return (int)_zDimensions.size(); }
+        int64_t LevelWidth(int level) const { return _zDimensions[level].first; }
+        int64_t LevelHeight(int level) const { return _zDimensions[level].second; }
+        int64_t LevelColumns(int level) const { return _tDimensions[level].first; }
+        int64_t LevelRows(int level) const { return _tDimensions[level].second; }
+        int TileSize() const { return _tileSize; }
+        int Overlap() const { return _overlap; }
+        bool LimitBounds() const { return _limitBounds; }
+        const std::string &SlideFileName() const { return _slide->fileName; }
+        SlideStats *Stats() const { return _slide->stats.get(); }
+        // Decode parallelism available from the slide's handle pool
+        size_t MaxThreads() const { return _slide->handles.MaxHandles(); }
+        // XML descriptor for a pyramid of tiles in format ("jpeg", "png")
+        std::string Dzi(const std::string &format) const;
+        // Size of a tile including overlap, false if it does not exist
+        bool GetTileSize(int level, int64_t col, int64_t row, int64_t *w, int64_t *h) const;
+        // Renders a tile as premultiplied ARGB into dest, which must hold
+        // the number of pixels given by GetTileSize. The source region is
+        // read and scaled in bands, see ReadRegionScaled.
+        bool ReadTile(int level, int64_t col, int64_t row, uint32_t *dest, std::string *error) const;
+        // Writes basename.dzi and every tile under basename_files/,
+        // rendering and encoding on up to threads threads, capped at the
+        // larger of MaxThreads and the core count. Tiles are
+        // written as soon as they are encoded, nothing is held per level.
+        bool ExportPyramid(const std::string &basename, const EncodeOptions &options,
+                           size_t threads, std::string *error) const;
+    private:
+        struct TileInfo {
+            int32_t slideLevel;
+            int64_t l0X;
+            int64_t l0Y;
+            int64_t lW;
+            int64_t lH;
+            int64_t zW;
+            int64_t zH;
+        };
+        bool GetTileInfo(int level, int64_t col, int64_t row, TileInfo *info) const;
+        std::shared_ptr<Slide> _slide;
+        int _tileSize;
+        int _overlap;
+        bool _limitBounds;
+        int64_t _l0OffsetX;
+        int64_t _l0OffsetY;
+        // Slide level sizes, clipped to the bounds with limitBounds
+        std::vector<std::pair<int64_t,int64_t> > _lDimensions;
+        // Deep Zoom level sizes in pixels and in tiles
+        std::vector<std::pair<int64_t,int64_t> > _zDimensions;
+        std::vector<std::pair<int64_t,int64_t> > _tDimensions;
+        std::vector<int32_t> _slideLevels;
+        // Slide level pixels per Deep Zoom level pixel
+        std::vector<double> _lzDownsamples;
+};
+
+// Extension used for tiles and in the DZI Format attribute
+const char *ImageFormatName(ImageFormat format);
+
+#endif
@@ -0,0 +1,215 @@
+#include "deepzoomgenerator.h"
+#include "deepzoomworker.h"
+#include "encodeoptions.h"
+#include "openslideobject.h"
+#include "regionreader.h"
+
+Nan::Persistent<v8::Function> DeepZoomGenerator::constructor;
+
+DeepZoomGenerator::DeepZoomGenerator(std::shared_ptr<DeepZoom> deepZoom) {
+    _deepZoom = deepZoom;
+}
+
+DeepZoomGenerator::~DeepZoomGenerator() {
+}
+
+void DeepZoomGenerator::Init(v8::Local<v8::Object> exports) {
+    Nan::HandleScope scope;
+
+    // Prepare constructor template
+    v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+    tpl->SetClassName(Nan::New("DeepZoomGenerator").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+    // Methods
+    Nan::SetPrototypeMethod(tpl,"getDzi",GetDzi);
+    Nan::SetPrototypeMethod(tpl,"getTile",GetTile);
+    Nan::SetPrototypeMethod(tpl,"exportPyramid",ExportPyramid);
+
+    // Properties
+    v8::Local<v8::ObjectTemplate> itpl = tpl->InstanceTemplate();
+    Nan::SetAccessor(itpl,
+                      Nan::New("levelCount").ToLocalChecked(),
+                      DeepZoomGenerator::GetLevelCount);
+    Nan::SetAccessor(itpl,
+                      Nan::New("tileCount").ToLocalChecked(),
+                      DeepZoomGenerator::GetTileCount);
+    Nan::SetAccessor(itpl,
+                      Nan::New("levelTiles").ToLocalChecked(),
+                      DeepZoomGenerator::GetLevelTiles);
+    Nan::SetAccessor(itpl,
+                      Nan::New("levelDimensions").ToLocalChecked(),
+                      DeepZoomGenerator::GetLevelDimensions);
+
+    constructor.Reset(Nan::GetFunction(tpl).ToLocalChecked());
+    Nan::Set(exports, Nan::New("DeepZoomGenerator").ToLocalChecked(),
+             Nan::GetFunction(tpl).ToLocalChecked());
+}
+
+// Reads an optional integer option
+static int32_t GetIntOption(v8::Local<v8::Value> options, const char *name, int32_t fallback) {
+  if (!options->IsObject()) {
+    return fallback;
+  }
+  v8::Local<v8::Value> value = Nan::Get(options.As<v8::Object>(),Nan::New(name).ToLocalChecked()).ToLocalChecked();
+  return value->IsUndefined() ? fallback : Nan::To<int32_t>(value).FromMaybe(0);
+}
+
+void DeepZoomGenerator::New(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  if (info.IsConstructCall()) {
+    // Invoked as constructor: `new DeepZoomGenerator(...)`
+    if (!OpenSlideObject::HasInstance(info[0])) {
+      Nan::ThrowTypeError("Wrong arguments");
+      return;
+    }
+    OpenSlideObject *slideObject = ObjectWrap::Unwrap<OpenSlideObject>(info[0].As<v8::Object>());
+    std::shared_ptr<Slide> slide = slideObject->GetSlide();
+    if (!slide) {
+      Nan::ThrowError("Slide is not open");
+      return;
+    }
+
+    int32_t tileSize = GetIntOption(info[1],"tileSize",254);
+    int32_t overlap = GetIntOption(info[1],"overlap",1);
+    bool limitBounds = false;
+    if (info[1]->IsObject()) {
+      v8::Local<v8::Value> value = Nan::Get(info[1].As<v8::Object>(),
+                                            Nan::New("limitBounds").ToLocalChecked()).ToLocalChecked();
+      limitBounds = Nan::To<bool>(value).FromMaybe(false);
+    }
+    if (tileSize <= 0 || tileSize > MAX_DEEPZOOM_TILE_SIZE || overlap < 0 || overlap > tileSize) {
+      Nan::ThrowRangeError("Invalid tile size or overlap");
+      return;
+    }
+
+    std::shared_ptr<DeepZoom> deepZoom = std::make_shared<DeepZoom>(slide,tileSize,overlap,limitBounds);
+    DeepZoomGenerator *obj = new DeepZoomGenerator(deepZoom);
+    obj->Wrap(info.This());
+    info.GetReturnValue().Set(info.This());
+  } else {
+    // Invoked as plain function `DeepZoomGenerator(...)`, turn into construct call.
+    const int argc = 2;
+    v8::Local<v8::Value> argv[argc] = { info[0], info[1] };
+    v8::Local<v8::Function> cons = Nan::New<v8::Function>(constructor);
+    info.GetReturnValue().Set(Nan::NewInstance(cons, argc, argv).ToLocalChecked());
+  }
+}
+
+void DeepZoomGenerator::GetDzi(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  DeepZoomGenerator *obj = ObjectWrap::Unwrap<DeepZoomGenerator>(info.Holder());
+  std::string format = "jpeg";
+  if (info.Length() > 0 && info[0]->IsString()) {
+    Nan::Utf8String val(info[0]);
+    format = *val;
+  }
+  info.GetReturnValue().Set(Nan::New(obj->_deepZoom->Dzi(format)).ToLocalChecked());
+}
+
+void DeepZoomGenerator::GetTile(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  DeepZoomGenerator *obj = ObjectWrap::Unwrap<DeepZoomGenerator>(info.Holder());
+
+  int callbackIndex = info.Length() - 1;
+  if (callbackIndex < 3 || callbackIndex > 4 || !info[callbackIndex]->IsFunction()) {
+    Nan::ThrowTypeError("Wrong arguments");
+    return;
+  }
+
+  int32_t level = Nan::To<int32_t>(info[0]).FromMaybe(0);
+  int64_t col = Nan::To<int64_t>(info[1]).FromMaybe(0);
+  int64_t row = Nan::To<int64_t>(info[2]).FromMaybe(0);
+  int64_t w = 0, h = 0;
+  if (!obj->_deepZoom->GetTileSize(level,col,row,&w,&h)) {
+    Nan::ThrowRangeError("Invalid tile address");
+    return;
+  }
+  if (!RegionFitsLimit(w,h)) {
+    Nan::ThrowRangeError("Tile size out of range");
+    return;
+  }
+  EncodeOptions options;
+  if (!ParseEncodeOptions(callbackIndex == 4 ? info[3] : Nan::Undefined().As<v8::Value>(),&options)) {
+    return;
+  }
+
+  Nan::Callback *callback = new Nan::Callback(info[callbackIndex].As<v8::Function>());
+  Nan::AsyncQueueWorker(new DeepZoomTileWorker(callback,obj->_deepZoom,level,col,row,options));
+}
+
+void DeepZoomGenerator::ExportPyramid(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  DeepZoomGenerator *obj = ObjectWrap::Unwrap<DeepZoomGenerator>(info.Holder());
+
+  int callbackIndex = info.Length() - 1;
+  if (callbackIndex < 1 || callbackIndex > 2 || !info[0]->IsString() ||
+      !info[callbackIndex]->IsFunction()) {
+    Nan::ThrowTypeError("Wrong arguments");
+    return;
+  }
+
+  Nan::Utf8String val(info[0]);
+  std::string basename (*val);
+  v8::Local<v8::Value> optionsValue = callbackIndex == 2 ? info[1] : Nan::Undefined().As<v8::Value>();
+  EncodeOptions options;
+  if (!ParseEncodeOptions(optionsValue,&options)) {
+    return;
+  }
+  // Tiles on disk are always encoded
+  if (options.format == FORMAT_RAW) {
+    options.format = FORMAT_JPEG;
+  }
+  int32_t threads = GetIntOption(optionsValue,"threads",
+                                 (int32_t)obj->_deepZoom->MaxThreads());
+  if (threads <= 0) {
+    Nan::ThrowRangeError("Invalid thread count");
+    return;
+  }
+  // Largest tile of the pyramid, edge tiles only get smaller
+  int64_t tileSide = obj->_deepZoom->TileSize() + 2 * obj->_deepZoom->Overlap();
+  if (!RegionFitsLimit(tileSide,tileSide)) {
+    Nan::ThrowRangeError("Tile size out of range");
+    return;
+  }
+
+  Nan::Callback *callback = new Nan::Callback(info[callbackIndex].As<v8::Function>());
+  Nan::AsyncQueueWorker(new DeepZoomExportWorker(callback,obj->_deepZoom,basename,options,threads));
+}
+
+NAN_GETTER(DeepZoomGenerator::GetLevelCount) {
+  DeepZoomGenerator *obj = ObjectWrap::Unwrap<DeepZoomGenerator>(info.Holder());
+  info.GetReturnValue().Set(Nan::New(obj->_deepZoom->LevelCount()));
+}
+
+NAN_GETTER(DeepZoomGenerator::GetTileCount) {
+  DeepZoomGenerator *obj = ObjectWrap::Unwrap<DeepZoomGenerator>(info.Holder());
+  double count = 0;
+  for (int i = 0; i < obj->_deepZoom->LevelCount(); i++) {
+    count += (double)obj->_deepZoom->LevelColumns(i) * obj->_deepZoom->LevelRows(i);
+  }
+  info.GetReturnValue().Set(Nan::New<v8::Number>(count));
+}
+
+NAN_GETTER(DeepZoomGenerator::GetLevelTiles) {
+  DeepZoomGenerator *obj = ObjectWrap::Unwrap<DeepZoomGenerator>(info.Holder());
+  int levelCount = obj->_deepZoom->LevelCount();
+
+  v8::Local<v8::Array> result = Nan::New<v8::Array>(levelCount);
+  for (int i = 0; i < levelCount; i++) {
+    v8::Local<v8::Array> tiles = Nan::New<v8::Array>(2);
+    Nan::Set(tiles,0, Nan::New<v8::Number>(obj->_deepZoom->LevelColumns(i)));
+    Nan::Set(tiles,1, Nan::New<v8::Number>(obj->_deepZoom->LevelRows(i)));
+    Nan::Set(result,i, tiles);
+  }
+  info.GetReturnValue().Set(result);
+}
+
+NAN_GETTER(DeepZoomGenerator::GetLevelDimensions) {
+  DeepZoomGenerator *obj = ObjectWrap::Unwrap<DeepZoomGenerator>(info.Holder());
+  int levelCount = obj->_deepZoom->LevelCount();
+
+  v8::Local<v8::Array> result = Nan::New<v8::Array>(levelCount);
+  for (int i = 0; i < levelCount; i++) {
+    v8::Local<v8::Array> dimensions = Nan::New<v8::Array>(2);
+    Nan::Set(dimensions,0, Nan::New<v8::Number>(obj->_deepZoom->LevelWidth(i)));
+    Nan::Set(dimensions,1, Nan::New<v8::Number>(obj->_deepZoom->LevelHeight(i)));
+    Nan::Set(result,i, dimensions);
+  }
+  info.GetReturnValue().Set(result);
+}
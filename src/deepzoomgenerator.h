@@ -0,0 +1,31 @@
+#ifndef DEEPZOOMGENERATOR_H
+#define DEEPZOOMGENERATOR_H
+
+#include <nan.h>
+#include <memory>
+#include "deepzoom.h"
+
+// JS wrapper around DeepZoom:
+// new DeepZoomGenerator(slide, { tileSize, overlap, limitBounds })
+class DeepZoomGenerator : public Nan::ObjectWrap {
+    public:
+        static void Init(v8::Local<v8::Object> exports);
+    private:
+        explicit DeepZoomGenerator(std::shared_ptr<DeepZoom> deepZoom);
+        ~DeepZoomGenerator();
+        // Methods
+        static Nan::Persistent<v8::Function> constructor;
+        static void New(const Nan::FunctionCallbackInfo<v8::Value>& info);
+        static void GetDzi(const Nan::FunctionCallbackInfo<v8::Value>& info);
+        static void GetTile(const Nan::FunctionCallbackInfo<v8::Value>& info);
+        static void ExportPyramid(const Nan::FunctionCallbackInfo<v8::Value>& info);
+        // Properties
+        static NAN_GETTER(GetLevelCount);
+        static NAN_GETTER(GetTileCount);
+        static NAN_GETTER(GetLevelTiles);
+        static NAN_GETTER(GetLevelDimensions);
+        // Fields
+        std::shared_ptr<DeepZoom> _deepZoom;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "deepzoomworker.h"
+#include "tilecache.h"
+#include <string.h>
+
+DeepZoomTileWorker::DeepZoomTileWorker(Nan::Callback *callback, std::shared_ptr<DeepZoom> deepZoom,
+                                       int level, int64_t col, int64_t row,
+                                       const EncodeOptions &options)
+  : Nan::AsyncWorker(callback), _deepZoom(deepZoom), _micros(0),
+    _level(level), _col(col), _row(row), _options(options) {
+}
+
+void DeepZoomTileWorker::Execute() {
+  OperationTimer timer(&_micros);
+  int64_t w = 0, h = 0;
+  if (!_deepZoom->GetTileSize(_level,_col,_row,&w,&h)) {
+    SetErrorMessage("Invalid tile address");
+    return;
+  }
+  TileKey key = DeepZoomTileKey(_deepZoom->SlideFileName(),_deepZoom->TileSize(),
+                                _deepZoom->Overlap(),_deepZoom->LimitBounds(),
+                                _level,_col,_row,_options);
+  bool cacheable = _options.format != FORMAT_RAW || tileCache.CacheRaw();
+  TileData cached = cacheable ? tileCache.Get(key) : TileData();
+  if (cached && _options.format != FORMAT_RAW) {
+    if (!_result.CopyEncoded(cached)) {
+      SetErrorMessage("Out of memory");
+    }
+    return;
+  }
+
+  if (!_result.Acquire(w * h * 4)) {
+    SetErrorMessage("Out of memory");
+    return;
+  }
+  if (cached) {
+    memcpy(_result.Pixels(),&(*cached)[0],_result.Size());
+    return;
+  }
+
+  std::string error;
+  if (!_deepZoom->ReadTile(_level,_col,_row,_result.Pixels(),&error) ||
+      !_result.Encode(w,h,_options,&error)) {
+    SetErrorMessage(error.c_str());
+    return;
+  }
+  if (cacheable) {
+    tileCache.Put(key,_result.Data(),_result.Size());
+  }
+}
+
+void DeepZoomTileWorker::HandleOKCallback() {
+  Nan::HandleScope scope;
+
+  _deepZoom->Stats()->RecordCall(OP_DEEPZOOM_TILE,_micros,_result.Size());
+
+  v8::Local<v8::Value> argv[] = { Nan::Null(), _result.ToBuffer() };
+  callback->Call(2, argv);
+}
+
+void DeepZoomTileWorker::HandleErrorCallback() {
+  _deepZoom->Stats()->RecordError(OP_DEEPZOOM_TILE,_micros);
+  Nan::AsyncWorker::HandleErrorCallback();
+}
+
+DeepZoomExportWorker::DeepZoomExportWorker(Nan::Callback *callback,
+                                           std::shared_ptr<DeepZoom> deepZoom,
+                                           const std::string &basename,
+                                           const EncodeOptions &options, size_t threads)
+  : Nan::AsyncWorker(callback), _deepZoom(deepZoom), _basename(basename),
+    _options(options), _threads(threads) {
+}
+
+void DeepZoomExportWorker::Execute() {
+  std::string error;
+  if (!_deepZoom->ExportPyramid(_basename,_options,_threads,&error)) {
+    SetErrorMessage(error.c_str());
+  }
+}
@@ -0,0 +1,45 @@
+#ifndef DEEPZOOMWORKER_H
+#define DEEPZOOMWORKER_H
+
+#include <nan.h>
+#include <memory>
+#include <string>
+#include "deepzoom.h"
+#include "encodedresult.h"
+#include "encoder.h"
+
+// Renders one Deep Zoom tile on the libuv thread pool, as raw ARGB or
+// encoded according to options
+class DeepZoomTileWorker : public Nan::AsyncWorker {
+    public:
+        DeepZoomTileWorker(Nan::Callback *callback, std::shared_ptr<DeepZoom> deepZoom,
+                           int level, int64_t col, int64_t row, const EncodeOptions &options);
+        void Execute();
+        void HandleOKCallback();
+        void HandleErrorCallback();
+    private:
+        std::shared_ptr<DeepZoom> _deepZoom;
+        uint64_t _micros;
+        int _level;
+        int64_t _col;
+        int64_t _row;
+        EncodeOptions _options;
+        EncodedResult _result;
+};
+
+// Writes a whole pyramid to disk. Occupies one libuv thread and fans
+// the tiles out over its own threads.
+class DeepZoomExportWorker : public Nan::AsyncWorker {
+    public:
+        DeepZoomExportWorker(Nan::Callback *callback, std::shared_ptr<DeepZoom> deepZoom,
+                             const std::string &basename, const EncodeOptions &options,
+                             size_t threads);
+        void Execute();
+    private:
+        std::shared_ptr<DeepZoom> _deepZoom;
+        std::string _basename;
+        EncodeOptions _options;
+        size_t _threads;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#include "encodedresult.h"
+#include "bufferpool.h"
+#include <stdlib.h>
+
+EncodedResult::EncodedResult() : _data(NULL), _size(0), _encoded(false) {
+}
+
+EncodedResult::~EncodedResult() {
+  if (_encoded) {
+    free(_data);
+  } else {
+    tilePool.Release(_data,_size);
+  }
+}
+
+bool EncodedResult::Acquire(size_t size) {
+  _data = tilePool.Acquire(size);
+  _size = size;
+  return _data != NULL;
+}
+
+bool EncodedResult::CopyEncoded(const TileData &data) {
+  _data = CopyTileData(data);
+  _size = data->size();
+  _encoded = true;
+  return _data != NULL;
+}
+
+bool EncodedResult::Encode(int64_t w, int64_t h, const EncodeOptions &options,
+                           std::string *error) {
+  if (options.format == FORMAT_RAW) {
+    return true;
+  }
+  char *encoded = NULL;
+  size_t encodedSize = 0;
+  bool ok = EncodeImage((uint32_t *)_data,w,h,options,&encoded,&encodedSize,error);
+  tilePool.Release(_data,_size);
+  _data = encoded;
+  _size = encodedSize;
+  _encoded = true;
+  return ok;
+}
+
+v8::Local<v8::Object> EncodedResult::ToBuffer() {
+  char *data = _data;
+  _data = NULL;
+  if (_encoded) {
+    // Nan frees it with free(), as EncodeImage and CopyTileData malloc
+    return Nan::NewBuffer(data,_size).ToLocalChecked();
+  }
+  return tilePool.NewBuffer(data,_size).ToLocalChecked();
+}
@@ -0,0 +1,36 @@
+#ifndef ENCODEDRESULT_H
+#define ENCODEDRESULT_H
+
+#include <nan.h>
+#include <string>
+#include "encoder.h"
+#include "tilecache.h"
+
+// The image a worker hands back to JS. Holds raw ARGB pixels in a
+// tilePool block until Encode replaces them with a malloc'ed encoded
+// image; whichever it holds is freed with the right allocator, here if
+// the result is dropped or by the Buffer from ToBuffer once collected.
+class EncodedResult {
+    public:
+        EncodedResult();
+        ~EncodedResult();
+        // Both return false when out of memory
+        bool Acquire(size_t size);
+        bool CopyEncoded(const TileData &data);
+        // Encodes the w x h pixels from Acquire, unless options ask for
+        // raw output. The pixels are released either way.
+        bool Encode(int64_t w, int64_t h, const EncodeOptions &options, std::string *error);
+        uint32_t *Pixels() const { return (uint32_t *)_data; }
+        const char *Data() const { return _data; }
+        size_t Size() const { return _size; }
+        // Must be called on the main thread, at most once
+        v8::Local<v8::Object> ToBuffer();
+    private:
+        EncodedResult(const EncodedResult &);
+        EncodedResult &operator=(const EncodedResult &);
+        char *_data;
+        size_t _size;
+        bool _encoded;
+};
+
+#endif
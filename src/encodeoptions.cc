@@ -0,0 +1,62 @@
+#include "encodeoptions.h"
+#include <stdlib.h>
+#include <string>
+
+bool ParseEncodeOptions(v8::Local<v8::Value> value, EncodeOptions *options) {
+  DefaultEncodeOptions(options);
+  if (value->IsUndefined()) {
+    return true;
+  }
+  if (!value->IsObject()) {
+    Nan::ThrowTypeError("Wrong arguments");
+    return false;
+  }
+  v8::Local<v8::Object> object = value.As<v8::Object>();
+
+  v8::Local<v8::Value> format = Nan::Get(object,Nan::New("format").ToLocalChecked()).ToLocalChecked();
+  if (!format->IsUndefined()) {
+    Nan::Utf8String val(format);
+    std::string name (*val);
+    if (name == "raw") {
+      options->format = FORMAT_RAW;
+    } else if (name == "jpeg" || name == "jpg") {
+      options->format = FORMAT_JPEG;
+    } else if (name == "png") {
+      options->format = FORMAT_PNG;
+    } else {
+      Nan::ThrowRangeError("Unknown image format");
+      return false;
+    }
+  }
+
+  v8::Local<v8::Value> quality = Nan::Get(object,Nan::New("quality").ToLocalChecked()).ToLocalChecked();
+  if (!quality->IsUndefined()) {
+    options->quality = Nan::To<int32_t>(quality).FromMaybe(0);
+    if (options->quality < 1 || options->quality > 100) {
+      Nan::ThrowRangeError("Quality must be between 1 and 100");
+      return false;
+    }
+  }
+
+  // Either 0xRRGGBB or "#rrggbb"
+  v8::Local<v8::Value> background = Nan::Get(object,Nan::New("background").ToLocalChecked()).ToLocalChecked();
+  if (background->IsNumber()) {
+    options->background = Nan::To<uint32_t>(background).FromMaybe(0) & 0xffffff;
+    options->hasBackground = true;
+  } else if (background->IsString()) {
+    Nan::Utf8String val(background);
+    std::string color (*val);
+    char *end = NULL;
+    if (color.size() != 7 || color[0] != '#') {
+      Nan::ThrowRangeError("Background must be #rrggbb");
+      return false;
+    }
+    options->background = strtoul(color.c_str() + 1,&end,16);
+    if (*end != 0) {
+      Nan::ThrowRangeError("Background must be #rrggbb");
+      return false;
+    }
+    options->hasBackground = true;
+  }
+  return true;
+}
@@ -0,0 +1,12 @@
+#ifndef ENCODEOPTIONS_H
+#define ENCODEOPTIONS_H
+
+#include <nan.h>
+#include "encoder.h"
+
+// Reads { format, quality, background } into options, leaving defaults
+// for anything missing or undefined. Throws and returns false on
+// invalid input.
+bool ParseEncodeOptions(v8::Local<v8::Value> value, EncodeOptions *options);
+
+#endif
@@ -0,0 +1,156 @@
+#include "encoder.h"
+#include "pixelconvert.h"
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <jpeglib.h>
+#include <png.h>
+
+void DefaultEncodeOptions(EncodeOptions *options) {
+  options->format = FORMAT_RAW;
+  options->quality = 75;
+  options->background = 0xffffff;
+  options->hasBackground = false;
+}
+
+// libjpeg reports errors through error_exit, which must not return
+struct JpegError {
+  struct jpeg_error_mgr mgr;
+  jmp_buf jump;
+  char message[JMSG_LENGTH_MAX];
+};
+
+static void JpegErrorExit(j_common_ptr cinfo) {
+  JpegError *error = (JpegError *)cinfo->err;
+  (*cinfo->err->format_message)(cinfo, error->message);
+  longjmp(error->jump, 1);
+}
+
+static bool EncodeJpeg(const uint32_t *pixels, int64_t w, int64_t h,
+                       const EncodeOptions &options,
+                       char **data, size_t *size, std::string *error) {
+  struct jpeg_compress_struct cinfo;
+  JpegError jerr;
+  unsigned char *output = NULL;
+  unsigned long outputSize = 0;
+  // Rows are converted one at a time, no full RGB copy of the image
+  std::vector<uint8_t> row(w * 3);
+
+  cinfo.err = jpeg_std_error(&jerr.mgr);
+  jerr.mgr.error_exit = JpegErrorExit;
+  if (setjmp(jerr.jump)) {
+    jpeg_destroy_compress(&cinfo);
+    free(output);
+    *error = jerr.message;
+    return false;
+  }
+
+  jpeg_create_compress(&cinfo);
+  jpeg_mem_dest(&cinfo, &output, &outputSize);
+  cinfo.image_width = (JDIMENSION)w;
+  cinfo.image_height = (JDIMENSION)h;
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, options.quality, TRUE);
+  jpeg_start_compress(&cinfo, TRUE);
+
+  while (cinfo.next_scanline < cinfo.image_height) {
+    ArgbToRgb(pixels + (int64_t)cinfo.next_scanline * w, &row[0], w, options.background);
+    JSAMPROW rowPointer = &row[0];
+    jpeg_write_scanlines(&cinfo, &rowPointer, 1);
+  }
+
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+
+  *data = (char *)output;
+  *size = outputSize;
+  return true;
+}
+
+struct PngOutput {
+  char *data;
+  size_t size;
+  size_t capacity;
+};
+
+static void PngWrite(png_structp png, png_bytep bytes, png_size_t length) {
+  PngOutput *output = (PngOutput *)png_get_io_ptr(png);
+  if (output->size + length > output->capacity) {
+    size_t capacity = output->capacity * 2;
+    if (capacity < output->size + length) {
+      capacity = output->size + length;
+    }
+    char *data = (char *)realloc(output->data, capacity);
+    if (data == NULL) {
+      png_error(png, "Out of memory");
+    }
+    output->data = data;
+    output->capacity = capacity;
+  }
+  memcpy(output->data + output->size, bytes, length);
+  output->size += length;
+}
+
+static void PngFlush(png_structp png) {
+}
+
+static bool EncodePng(const uint32_t *pixels, int64_t w, int64_t h,
+                      const EncodeOptions &options,
+                      char **data, size_t *size, std::string *error) {
+  png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (png == NULL) {
+    *error = "Cannot create PNG encoder";
+    return false;
+  }
+  png_infop info = png_create_info_struct(png);
+  int channels = options.hasBackground ? 3 : 4;
+  PngOutput output = { NULL, 0, 0 };
+  std::vector<uint8_t> row(w * channels);
+
+  if (info == NULL || setjmp(png_jmpbuf(png))) {
+    png_destroy_write_struct(&png, &info);
+    free(output.data);
+    *error = "PNG encoding failed";
+    return false;
+  }
+
+  png_set_write_fn(png, &output, PngWrite, PngFlush);
+  png_set_IHDR(png, info, (png_uint_32)w, (png_uint_32)h, 8,
+               channels == 3 ? PNG_COLOR_TYPE_RGB : PNG_COLOR_TYPE_RGB_ALPHA,
+               PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  png_write_info(png, info);
+
+  for (int64_t y = 0; y < h; y++) {
+    if (channels == 3) {
+      ArgbToRgb(pixels + y * w, &row[0], w, options.background);
+    } else {
+      ArgbToRgba(pixels + y * w, &row[0], w);
+    }
+    png_write_row(png, &row[0]);
+  }
+
+  png_write_end(png, info);
+  png_destroy_write_struct(&png, &info);
+
+  *data = output.data;
+  *size = output.size;
+  return true;
+}
+
+bool EncodeImage(const uint32_t *pixels, int64_t w, int64_t h,
+                 const EncodeOptions &options,
+                 char **data, size_t *size, std::string *error) {
+  switch (options.format) {
+    case FORMAT_JPEG:
+      return EncodeJpeg(pixels, w, h, options, data, size, error);
+    case FORMAT_PNG:
+      return EncodePng(pixels, w, h, options, data, size, error);
+    default:
+      *error = "Unknown image format";
+      return false;
+  }
+}
@@ -0,0 +1,32 @@
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+enum ImageFormat {
+  FORMAT_RAW,
+  FORMAT_JPEG,
+  FORMAT_PNG
+};
+
+struct EncodeOptions {
+  ImageFormat format;
+  // JPEG quality, 1-100
+  int quality;
+  // 0xRRGGBB composited under transparent areas. JPEG always uses it;
+  // PNG keeps an alpha channel unless hasBackground is set.
+  uint32_t background;
+  bool hasBackground;
+};
+
+void DefaultEncodeOptions(EncodeOptions *options);
+
+// Encodes premultiplied ARGB pixels. On success *data is a malloc'ed
+// buffer owned by the caller. Returns false and sets error on failure.
+bool EncodeImage(const uint32_t *pixels, int64_t w, int64_t h,
+                 const EncodeOptions &options,
+                 char **data, size_t *size, std::string *error);
+
+#endif
@@ -0,0 +1,83 @@
+#include "handlepool.h"
+
+HandlePool::HandlePool(const std::string &fileName, openslide_t *first, size_t maxHandles,
+                       HandleBudget *budget)
+  : _fileName(fileName), _budget(budget), _maxHandles(maxHandles > 0 ? maxHandles : 1),
+    _openHandles(0) {
+  if (first != NULL) {
+    _idle.push_back(first);
+    _openHandles = 1;
+  }
+}
+
+HandlePool::~HandlePool() {
+  for (size_t i = 0; i < _idle.size(); i++) {
+    openslide_close(_idle[i]);
+    if (_budget != NULL) {
+      _budget->Return();
+    }
+  }
+}
+
+openslide_t *HandlePool::Acquire() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  // Set once the budget turns us down; from then on we wait for a
+  // release, unless the pool has lost all its handles
+  bool refused = false;
+  for (;;) {
+    if (!_idle.empty()) {
+      openslide_t *osr = _idle.back();
+      _idle.pop_back();
+      return osr;
+    }
+    if (_openHandles >= _maxHandles || (refused && _openHandles > 0)) {
+      _available.wait(lock);
+      continue;
+    }
+
+    // Reserve the slot, then open without holding the lock
+    bool only = _openHandles == 0;
+    _openHandles++;
+    lock.unlock();
+    if (_budget != NULL && !_budget->Reserve(only)) {
+      lock.lock();
+      _openHandles--;
+      refused = true;
+      continue;
+    }
+    openslide_t *osr = openslide_open(_fileName.c_str());
+    if (osr == NULL) {
+      if (_budget != NULL) {
+        _budget->Return();
+      }
+      lock.lock();
+      _openHandles--;
+      _available.notify_one();
+    }
+    return osr;
+  }
+}
+
+size_t HandlePool::OpenHandles() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _openHandles;
+}
+
+void HandlePool::Release(openslide_t *osr) {
+  // openslide errors are sticky, so a failed handle is useless from here on
+  bool failed = openslide_get_error(osr) != NULL;
+  if (failed) {
+    openslide_close(osr);
+    if (_budget != NULL) {
+      _budget->Return();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (failed) {
+    _openHandles--;
+  } else {
+    _idle.push_back(osr);
+  }
+  _available.notify_one();
+}
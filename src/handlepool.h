@@ -0,0 +1,46 @@
+#ifndef HANDLEPOOL_H
+#define HANDLEPOOL_H
+
+#include <openslide/openslide.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Process-wide limit on open handles, charged by every HandlePool
+class HandleBudget {
+    public:
+        virtual ~HandleBudget() {}
+        // Takes one handle from the budget, false if it is used up. A
+        // forced reservation always succeeds, for a pool's only handle.
+        virtual bool Reserve(bool force) = 0;
+        // Gives back a handle that was closed
+        virtual void Return() = 0;
+};
+
+// A set of openslide_t handles on the same file. openslide serialises
+// some work per handle, so parallel decodes each check out their own.
+// Handles are opened lazily up to maxHandles, and beyond the first only
+// while budget has room; otherwise Acquire waits for one to be released.
+// first must already be charged to budget.
+class HandlePool {
+    public:
+        HandlePool(const std::string &fileName, openslide_t *first, size_t maxHandles,
+                   HandleBudget *budget = NULL);
+        ~HandlePool();
+        // Returns NULL if a new handle could not be opened
+        openslide_t *Acquire();
+        void Release(openslide_t *osr);
+        size_t MaxHandles() const { return _maxHandles; }
+        size_t OpenHandles();
+    private:
+        std::string _fileName;
+        HandleBudget *_budget;
+        size_t _maxHandles;
+        size_t _openHandles;
+        std::vector<openslide_t *> _idle;
+        std::mutex _mutex;
+        std::condition_variable _available;
+};
+
+#endif
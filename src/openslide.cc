@@ -2,6 +2,11 @@
 #include <openslide/openslide.h>
 #include <string>
 #include "openslideobject.h"
+#include "deepzoomgenerator.h"
+#include "regionreader.h"
+#include "slideregistry.h"
+#include "slidestats.h"
+#include "tilecache.h"
 
 using namespace std;
 using namespace Nan;
@@ -19,18 +24,180 @@ void Detect_Vendor(const Nan::FunctionCallbackInfo<v8::Value>& info) {
     return;
   }
 
-  v8::String::Utf8Value val(info[0]->ToString());
+  Nan::Utf8String val(info[0]);
   std::string filePath (*val);
   const char *vendor = openslide_detect_vendor(filePath.c_str());
 
   info.GetReturnValue().Set(Nan::New<String>(vendor).ToLocalChecked());
 }
 
+void Set_Max_Region_Bytes(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+
+  double maxBytes = 0;
+  if (info.Length() > 0 && info[0]->IsNumber()) {
+    maxBytes = Nan::To<double>(info[0]).FromMaybe(0);
+  }
+  if (maxBytes <= 0) {
+    Nan::ThrowTypeError("Wrong arguments");
+    return;
+  }
+
+  SetMaxRegionBytes((size_t)maxBytes);
+}
+
+void Get_Max_Region_Bytes(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  info.GetReturnValue().Set(Nan::New<v8::Number>((double)GetMaxRegionBytes()));
+}
+
+// Reads an optional positive integer option, keeping current if absent
+static size_t Get_Size_Option(v8::Local<v8::Object> options, const char *name, size_t current) {
+  v8::Local<v8::Value> value = Nan::Get(options, Nan::New(name).ToLocalChecked()).ToLocalChecked();
+  double number = value->IsNumber() ? Nan::To<double>(value).FromMaybe(-1) : -1;
+  if (number < 0) {
+    return current;
+  }
+  return (size_t)number;
+}
+
+void Configure_Slide_Cache(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+
+  if (info.Length() == 0 || !info[0]->IsObject()) {
+    Nan::ThrowTypeError("Wrong arguments");
+    return;
+  }
+
+  v8::Local<v8::Object> options = info[0].As<v8::Object>();
+  size_t maxSlides = Get_Size_Option(options, "maxSlides", slideRegistry.MaxSlides());
+  size_t maxHandles = Get_Size_Option(options, "maxHandles", slideRegistry.MaxHandles());
+  size_t handlesPerSlide = Get_Size_Option(options, "handlesPerSlide", slideRegistry.HandlesPerSlide());
+  slideRegistry.Configure(maxSlides, maxHandles, handlesPerSlide);
+}
+
+void Clear_Slide_Cache(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  slideRegistry.Clear();
+}
+
+void Configure_Tile_Cache(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+
+  if (info.Length() == 0 || !info[0]->IsObject()) {
+    Nan::ThrowTypeError("Wrong arguments");
+    return;
+  }
+
+  TileCacheStats stats;
+  tileCache.GetStats(&stats);
+  v8::Local<v8::Object> options = info[0].As<v8::Object>();
+  tileCache.SetMaxBytes(Get_Size_Option(options, "maxBytes", stats.maxBytes));
+  v8::Local<v8::Value> cacheRaw = Nan::Get(options, Nan::New("cacheRaw").ToLocalChecked()).ToLocalChecked();
+  if (!cacheRaw->IsUndefined()) {
+    tileCache.SetCacheRaw(Nan::To<bool>(cacheRaw).FromMaybe(false));
+  }
+}
+
+void Clear_Tile_Cache(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  tileCache.Clear();
+}
+
+static v8::Local<v8::Object> Tile_Cache_Stats_Object() {
+  TileCacheStats stats;
+  tileCache.GetStats(&stats);
+
+  v8::Local<v8::Object> result = Nan::New<v8::Object>();
+  Nan::Set(result, Nan::New("hits").ToLocalChecked(), Nan::New<v8::Number>((double)stats.hits));
+  Nan::Set(result, Nan::New("misses").ToLocalChecked(), Nan::New<v8::Number>((double)stats.misses));
+  Nan::Set(result, Nan::New("insertions").ToLocalChecked(), Nan::New<v8::Number>((double)stats.insertions));
+  Nan::Set(result, Nan::New("evictions").ToLocalChecked(), Nan::New<v8::Number>((double)stats.evictions));
+  Nan::Set(result, Nan::New("entries").ToLocalChecked(), Nan::New<v8::Number>((double)stats.entries));
+  Nan::Set(result, Nan::New("bytes").ToLocalChecked(), Nan::New<v8::Number>((double)stats.bytes));
+  Nan::Set(result, Nan::New("maxBytes").ToLocalChecked(), Nan::New<v8::Number>((double)stats.maxBytes));
+  return result;
+}
+
+void Get_Tile_Cache_Stats(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  info.GetReturnValue().Set(Tile_Cache_Stats_Object());
+}
+
+// {totalMicros, histogram}, histogram[i] counting [2^i, 2^(i+1)) us
+static v8::Local<v8::Object> Latency_Object(const LatencySnapshot &latency) {
+  v8::Local<v8::Array> histogram = Nan::New<v8::Array>(LATENCY_BUCKETS);
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    Nan::Set(histogram, i, Nan::New<v8::Number>((double)latency.buckets[i]));
+  }
+  v8::Local<v8::Object> result = Nan::New<v8::Object>();
+  Nan::Set(result, Nan::New("totalMicros").ToLocalChecked(), Nan::New<v8::Number>((double)latency.micros));
+  Nan::Set(result, Nan::New("histogram").ToLocalChecked(), histogram);
+  return result;
+}
+
+static v8::Local<v8::Object> Slide_Stats_Object(const SlideStatsSnapshot &stats) {
+  v8::Local<v8::Object> operations = Nan::New<v8::Object>();
+  for (size_t i = 0; i < OP_COUNT; i++) {
+    const OperationSnapshot &op = stats.operations[i];
+    v8::Local<v8::Object> opStats = Nan::New<v8::Object>();
+    Nan::Set(opStats, Nan::New("calls").ToLocalChecked(), Nan::New<v8::Number>((double)op.latency.count));
+    Nan::Set(opStats, Nan::New("errors").ToLocalChecked(), Nan::New<v8::Number>((double)op.errors));
+    Nan::Set(opStats, Nan::New("bytes").ToLocalChecked(), Nan::New<v8::Number>((double)op.bytes));
+    Nan::Set(opStats, Nan::New("latency").ToLocalChecked(), Latency_Object(op.latency));
+    Nan::Set(operations, Nan::New(SlideOperationName((SlideOperation)i)).ToLocalChecked(), opStats);
+  }
+
+  v8::Local<v8::Object> decode = Nan::New<v8::Object>();
+  Nan::Set(decode, Nan::New("calls").ToLocalChecked(), Nan::New<v8::Number>((double)stats.decodeLatency.count));
+  Nan::Set(decode, Nan::New("pixels").ToLocalChecked(), Nan::New<v8::Number>((double)stats.decodedPixels));
+  Nan::Set(decode, Nan::New("latency").ToLocalChecked(), Latency_Object(stats.decodeLatency));
+
+  v8::Local<v8::Object> result = Nan::New<v8::Object>();
+  Nan::Set(result, Nan::New("fileName").ToLocalChecked(), Nan::New(stats.fileName).ToLocalChecked());
+  Nan::Set(result, Nan::New("opens").ToLocalChecked(), Nan::New<v8::Number>((double)stats.opens));
+  Nan::Set(result, Nan::New("coldOpens").ToLocalChecked(), Nan::New<v8::Number>((double)stats.coldOpens));
+  Nan::Set(result, Nan::New("coldOpenLatency").ToLocalChecked(), Latency_Object(stats.coldOpenLatency));
+  Nan::Set(result, Nan::New("operations").ToLocalChecked(), operations);
+  Nan::Set(result, Nan::New("decode").ToLocalChecked(), decode);
+  return result;
+}
+
+void Get_Stats(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  std::vector<SlideStatsSnapshot> snapshots;
+  slideStats.Snapshot(&snapshots);
+
+  v8::Local<v8::Array> slides = Nan::New<v8::Array>(snapshots.size());
+  for (size_t i = 0; i < snapshots.size(); i++) {
+    Nan::Set(slides, i, Slide_Stats_Object(snapshots[i]));
+  }
+  v8::Local<v8::Object> result = Nan::New<v8::Object>();
+  Nan::Set(result, Nan::New("slides").ToLocalChecked(), slides);
+  Nan::Set(result, Nan::New("tileCache").ToLocalChecked(), Tile_Cache_Stats_Object());
+  info.GetReturnValue().Set(result);
+}
+
+void Reset_Stats(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  slideStats.Reset();
+}
+
 void Init(v8::Local<v8::Object> exports) {
-  exports->Set(Nan::New("detect_vendor").ToLocalChecked(),
-               Nan::New<v8::FunctionTemplate>(Detect_Vendor)->GetFunction());
+  Nan::Set(exports, Nan::New("detect_vendor").ToLocalChecked(),
+           Nan::GetFunction(Nan::New<v8::FunctionTemplate>(Detect_Vendor)).ToLocalChecked());
+  Nan::Set(exports, Nan::New("setMaxRegionBytes").ToLocalChecked(),
+           Nan::GetFunction(Nan::New<v8::FunctionTemplate>(Set_Max_Region_Bytes)).ToLocalChecked());
+  Nan::Set(exports, Nan::New("getMaxRegionBytes").ToLocalChecked(),
+           Nan::GetFunction(Nan::New<v8::FunctionTemplate>(Get_Max_Region_Bytes)).ToLocalChecked());
+  Nan::Set(exports, Nan::New("configureSlideCache").ToLocalChecked(),
+           Nan::GetFunction(Nan::New<v8::FunctionTemplate>(Configure_Slide_Cache)).ToLocalChecked());
+  Nan::Set(exports, Nan::New("clearSlideCache").ToLocalChecked(),
+           Nan::GetFunction(Nan::New<v8::FunctionTemplate>(Clear_Slide_Cache)).ToLocalChecked());
+  Nan::Set(exports, Nan::New("configureTileCache").ToLocalChecked(),
+           Nan::GetFunction(Nan::New<v8::FunctionTemplate>(Configure_Tile_Cache)).ToLocalChecked());
+  Nan::Set(exports, Nan::New("clearTileCache").ToLocalChecked(),
+           Nan::GetFunction(Nan::New<v8::FunctionTemplate>(Clear_Tile_Cache)).ToLocalChecked());
+  Nan::Set(exports, Nan::New("getTileCacheStats").ToLocalChecked(),
+           Nan::GetFunction(Nan::New<v8::FunctionTemplate>(Get_Tile_Cache_Stats)).ToLocalChecked());
+  Nan::Set(exports, Nan::New("getStats").ToLocalChecked(),
+           Nan::GetFunction(Nan::New<v8::FunctionTemplate>(Get_Stats)).ToLocalChecked());
+  Nan::Set(exports, Nan::New("resetStats").ToLocalChecked(),
+           Nan::GetFunction(Nan::New<v8::FunctionTemplate>(Reset_Stats)).ToLocalChecked());
 
   OpenSlideObject::Init(exports);
+  DeepZoomGenerator::Init(exports);
 }
 
 NODE_MODULE(openslide, Init)
\ No newline at end of file
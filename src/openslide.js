@@ -11,6 +11,9 @@ console.log("level downsamples = ", obj.levelDownsamples);
 console.log("property names = ", obj.propertyNames);
 console.log("property value = ", obj.getPropertyValue('aperio.ScanScope ID'));
 console.log("tile = ", obj.readRegion(0,0,0,256,256));
+obj.readRegionAsync(0,0,0,256,256,function(err,tile) {
+  console.log("async tile = ", err || tile);
+});
 
 //var vendor = addon.detect_vendor("/Users/gaoyongqing/Documents/projects/slideonly/openslide-node/data/CMU-1.svs"); 
 //console.log(vendor);
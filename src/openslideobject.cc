@@ -1,18 +1,22 @@
 #include "openslideobject.h"
+#include "readregionworker.h"
+#include "readregionsworker.h"
+#include "slideimageworker.h"
+#include "thumbnail.h"
+#include "bufferpool.h"
+#include "regionreader.h"
+#include "slideregistry.h"
+#include "encodeoptions.h"
+#include <stdint.h>
 
 Nan::Persistent<v8::Function> OpenSlideObject::constructor;
-
-static const size_t DATA_SIZE = 256 * 256 * 4;
-static char data[DATA_SIZE];
+Nan::Persistent<v8::FunctionTemplate> OpenSlideObject::tmpl;
 
 OpenSlideObject::OpenSlideObject(string fileName) {
     _fileName = fileName;
 }
 
 OpenSlideObject::~OpenSlideObject() {
-  if (_osr != NULL) {
-    openslide_close(_osr);
-  }
 }
 
 void OpenSlideObject::Init(v8::Local<v8::Object> exports) {
@@ -25,6 +29,11 @@ void OpenSlideObject::Init(v8::Local<v8::Object> exports) {
     // Methods
     Nan::SetPrototypeMethod(tpl,"open",Open);
     Nan::SetPrototypeMethod(tpl,"readRegion",ReadRegion);
+    Nan::SetPrototypeMethod(tpl,"readRegionAsync",ReadRegionAsync);
+    Nan::SetPrototypeMethod(tpl,"readRegionInto",ReadRegionInto);
+    Nan::SetPrototypeMethod(tpl,"readRegions",ReadRegions);
+    Nan::SetPrototypeMethod(tpl,"getThumbnail",GetThumbnail);
+    Nan::SetPrototypeMethod(tpl,"readAssociatedImage",ReadAssociatedImage);
     Nan::SetPrototypeMethod(tpl,"getPropertyValue",GetPropertyValue);
 
     // Properties
@@ -44,16 +53,25 @@ void OpenSlideObject::Init(v8::Local<v8::Object> exports) {
     Nan::SetAccessor(itpl,
                       Nan::New("propertyNames").ToLocalChecked(),
                       OpenSlideObject::GetSlidePropertyNames);
+    Nan::SetAccessor(itpl,
+                      Nan::New("associatedImageNames").ToLocalChecked(),
+                      OpenSlideObject::GetAssociatedImageNames);
 
-    constructor.Reset(tpl->GetFunction());
-    exports->Set(Nan::New("OpenSlideObject").ToLocalChecked(), tpl->GetFunction());
+    tmpl.Reset(tpl);
+    constructor.Reset(Nan::GetFunction(tpl).ToLocalChecked());
+    Nan::Set(exports, Nan::New("OpenSlideObject").ToLocalChecked(),
+             Nan::GetFunction(tpl).ToLocalChecked());
     
 }
 
+bool OpenSlideObject::HasInstance(v8::Local<v8::Value> value) {
+  return Nan::New(tmpl)->HasInstance(value);
+}
+
 void OpenSlideObject::New(const Nan::FunctionCallbackInfo<v8::Value>& info) {
   if (info.IsConstructCall()) {
     // Invoked as constructor: `new OpenSlideObject(...)`
-    v8::String::Utf8Value val(info[0]->ToString());
+    Nan::Utf8String val(info[0]);
     std::string filePath (*val);
     OpenSlideObject *obj = new OpenSlideObject(filePath);
     obj->Wrap(info.This());
@@ -63,86 +81,301 @@ void OpenSlideObject::New(const Nan::FunctionCallbackInfo<v8::Value>& info) {
     const int argc = 1;
     v8::Local<v8::Value> argv[argc] = { info[0] };
     v8::Local<v8::Function> cons = Nan::New<v8::Function>(constructor);
-    info.GetReturnValue().Set(cons->NewInstance(argc, argv));
+    info.GetReturnValue().Set(Nan::NewInstance(cons, argc, argv).ToLocalChecked());
   }
 }
 
 void OpenSlideObject::Open(const Nan::FunctionCallbackInfo<v8::Value>& info) {
     OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
-    openslide_t *osr = openslide_open(obj->_fileName.c_str());
-    bool success = osr != NULL;
-    if (!success) {
-      info.GetReturnValue().Set(Nan::New(success));
-      return;
-    }
-
-    // Assign osr to member variable
-    obj->_osr = osr;
-
-    // Store level count
-    int32_t levelCount = openslide_get_level_count(osr);
-    obj->_levelCount = levelCount;
-
-    // Store dimensions
-    for (int i = 0; i < levelCount; i++) {
-      int64_t w, h;
-      double downsample;
-      openslide_get_level_dimensions(osr,i,&w,&h);
-      downsample = openslide_get_level_downsample(osr,i);
-      obj->_levelWidths.push_back(w);
-      obj->_levelHeights.push_back(h);
-      obj->_levelDownsamples.push_back(downsample);
+    if (!obj->_slide) {
+      // Reuses the handles and metadata of an already open slide if any
+      obj->_slide = slideRegistry.Open(obj->_fileName);
     }
+    bool success = obj->_slide.get() != NULL;
 
-    // Properties
-    const char* const *pNames = openslide_get_property_names(osr);
-    int i = 0; 
-    while (pNames[i] != 0) {
-      const char *pValue = openslide_get_property_value(osr,pNames[i]);
-      obj->_properties[pNames[i]] = pValue;
-      i++;
-    }
-    
     // Return success
     info.GetReturnValue().Set(Nan::New(success));
 }
 
+bool OpenSlideObject::CheckRegion(int32_t level, int64_t w, int64_t h) {
+  if (!_slide) {
+    Nan::ThrowError("Slide is not open");
+    return false;
+  }
+  if (level < 0 || level >= _slide->levelCount) {
+    Nan::ThrowRangeError("Level out of range");
+    return false;
+  }
+  if (!RegionFitsLimit(w,h)) {
+    Nan::ThrowRangeError("Region size out of range");
+    return false;
+  }
+  return true;
+}
+
 void OpenSlideObject::ReadRegion(const Nan::FunctionCallbackInfo<v8::Value>& info) {
   OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
-  openslide_t *osr = obj->_osr;
 
-  int32_t level = info[0]->Int32Value();
-  int64_t x = info[1]->Int32Value();
-  int64_t y = info[2]->Int32Value();
-  int64_t w = info[3]->Int32Value();
-  int64_t h = info[4]->Int32Value();
-  if (w > 256 || h > 256) {
-    info.GetReturnValue().Set(Nan::New(0));
+  int32_t level = Nan::To<int32_t>(info[0]).FromMaybe(0);
+  int64_t x = Nan::To<int32_t>(info[1]).FromMaybe(0);
+  int64_t y = Nan::To<int32_t>(info[2]).FromMaybe(0);
+  int64_t w = Nan::To<int32_t>(info[3]).FromMaybe(0);
+  int64_t h = Nan::To<int32_t>(info[4]).FromMaybe(0);
+  if (!obj->CheckRegion(level,w,h)) {
+    return;
+  }
+
+  // Decode into a pooled block and hand it to JS without copying
+  int64_t dataSize = w * h * 4;
+  char *data = tilePool.Acquire(dataSize);
+  if (data == NULL) {
+    Nan::ThrowError("Out of memory");
+    return;
+  }
+  std::string error;
+  uint64_t start = NowMicros();
+  if (!ReadRegionCached(obj->_slide.get(),(uint32_t *)data,x,y,level,w,h,true,&error)) {
+    obj->_slide->stats->RecordError(OP_READ_REGION,NowMicros() - start);
+    tilePool.Release(data,dataSize);
+    Nan::ThrowError(error.c_str());
+    return;
+  }
+  obj->_slide->stats->RecordCall(OP_READ_REGION,NowMicros() - start,dataSize);
+  info.GetReturnValue().Set(tilePool.NewBuffer(data,dataSize).ToLocalChecked());
+}
+
+void OpenSlideObject::ReadRegionAsync(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
+
+  // Options are optional, the callback always comes last
+  int callbackIndex = info.Length() - 1;
+  if (callbackIndex < 5 || callbackIndex > 6 || !info[callbackIndex]->IsFunction()) {
+    Nan::ThrowTypeError("Wrong arguments");
+    return;
+  }
+
+  int32_t level = Nan::To<int32_t>(info[0]).FromMaybe(0);
+  int64_t x = Nan::To<int32_t>(info[1]).FromMaybe(0);
+  int64_t y = Nan::To<int32_t>(info[2]).FromMaybe(0);
+  int64_t w = Nan::To<int32_t>(info[3]).FromMaybe(0);
+  int64_t h = Nan::To<int32_t>(info[4]).FromMaybe(0);
+  if (!obj->CheckRegion(level,w,h)) {
+    return;
+  }
+  EncodeOptions encode;
+  if (!ParseEncodeOptions(callbackIndex == 6 ? info[5] : Nan::Undefined().As<v8::Value>(),&encode)) {
+    return;
+  }
+
+  Nan::Callback *callback = new Nan::Callback(info[callbackIndex].As<v8::Function>());
+  ReadRegionWorker *worker = new ReadRegionWorker(callback,obj->_slide,level,x,y,w,h);
+  worker->SetEncodeOptions(encode);
+  Nan::AsyncQueueWorker(worker);
+}
+
+void OpenSlideObject::ReadRegionInto(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
+
+  if (info.Length() < 7 || !node::Buffer::HasInstance(info[0])) {
+    Nan::ThrowTypeError("Wrong arguments");
     return;
   }
 
-  openslide_read_region(osr,(uint32_t *)&data,x,y,level,w,h);
+  v8::Local<v8::Object> buffer = info[0].As<v8::Object>();
+  int64_t offset = Nan::To<int64_t>(info[1]).FromMaybe(0);
+  int32_t level = Nan::To<int32_t>(info[2]).FromMaybe(0);
+  int64_t x = Nan::To<int32_t>(info[3]).FromMaybe(0);
+  int64_t y = Nan::To<int32_t>(info[4]).FromMaybe(0);
+  int64_t w = Nan::To<int32_t>(info[5]).FromMaybe(0);
+  int64_t h = Nan::To<int32_t>(info[6]).FromMaybe(0);
+  if (!obj->CheckRegion(level,w,h)) {
+    return;
+  }
+
+  // Written so that no operand can overflow
   int64_t dataSize = w * h * 4;
-  info.GetReturnValue().Set(CopyBuffer(data,dataSize).ToLocalChecked());
+  int64_t length = (int64_t)node::Buffer::Length(buffer);
+  if (offset < 0 || offset > length || dataSize > length - offset) {
+    Nan::ThrowRangeError("Buffer too small for region");
+    return;
+  }
+  // openslide writes whole uint32_t pixels straight into the Buffer
+  char *dest = node::Buffer::Data(buffer) + offset;
+  if ((uintptr_t)dest % sizeof(uint32_t) != 0) {
+    Nan::ThrowRangeError("Buffer offset must be 4-byte aligned");
+    return;
+  }
+
+  if (info.Length() > 7 && info[7]->IsFunction()) {
+    Nan::Callback *callback = new Nan::Callback(info[7].As<v8::Function>());
+    ReadRegionWorker *worker = new ReadRegionWorker(callback,obj->_slide,level,x,y,w,h,dest);
+    worker->SaveToPersistent("buffer",buffer);
+    Nan::AsyncQueueWorker(worker);
+    return;
+  }
+
+  // The Buffer is the caller's, so it is read from the cache but never
+  // copied into it
+  std::string error;
+  uint64_t start = NowMicros();
+  if (!ReadRegionCached(obj->_slide.get(),(uint32_t *)dest,x,y,level,w,h,false,&error)) {
+    obj->_slide->stats->RecordError(OP_READ_REGION,NowMicros() - start);
+    Nan::ThrowError(error.c_str());
+    return;
+  }
+  obj->_slide->stats->RecordCall(OP_READ_REGION,NowMicros() - start,dataSize);
+  info.GetReturnValue().Set(buffer);
+}
+
+static int32_t GetInt32(v8::Local<v8::Object> object, const char *name) {
+  v8::Local<v8::Value> value = Nan::Get(object,Nan::New(name).ToLocalChecked()).ToLocalChecked();
+  return Nan::To<int32_t>(value).FromMaybe(0);
+}
+
+void OpenSlideObject::ReadRegions(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
+
+  int callbackIndex = info.Length() - 1;
+  if (callbackIndex < 1 || callbackIndex > 2 || !info[0]->IsArray() ||
+      !info[callbackIndex]->IsFunction()) {
+    Nan::ThrowTypeError("Wrong arguments");
+    return;
+  }
+  EncodeOptions encode;
+  if (!ParseEncodeOptions(callbackIndex == 2 ? info[1] : Nan::Undefined().As<v8::Value>(),&encode)) {
+    return;
+  }
+
+  v8::Local<v8::Array> list = info[0].As<v8::Array>();
+  std::vector<Region> requests(list->Length());
+  uint64_t totalSize = 0;
+  for (uint32_t i = 0; i < list->Length(); i++) {
+    v8::Local<v8::Value> item = Nan::Get(list,i).ToLocalChecked();
+    if (!item->IsObject()) {
+      Nan::ThrowTypeError("Wrong arguments");
+      return;
+    }
+    v8::Local<v8::Object> request = item.As<v8::Object>();
+    Region &region = requests[i];
+    region.level = GetInt32(request,"level");
+    region.x = GetInt32(request,"x");
+    region.y = GetInt32(request,"y");
+    region.w = GetInt32(request,"w");
+    region.h = GetInt32(request,"h");
+    if (!obj->CheckRegion(region.level,region.w,region.h)) {
+      return;
+    }
+    // The whole batch is in memory at once, so it shares one budget.
+    // Each region fits, so checking as it grows keeps the sum in range.
+    totalSize += (uint64_t)region.w * (uint64_t)region.h * 4;
+    if (totalSize > GetMaxRegionBytes()) {
+      Nan::ThrowRangeError("Region size out of range");
+      return;
+    }
+  }
+
+  Nan::Callback *callback = new Nan::Callback(info[callbackIndex].As<v8::Function>());
+  Nan::AsyncQueueWorker(new ReadRegionsWorker(callback,obj->_slide,requests,encode));
+}
+
+void OpenSlideObject::GetThumbnail(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
+
+  int callbackIndex = info.Length() - 1;
+  if (callbackIndex < 2 || callbackIndex > 3 || !info[callbackIndex]->IsFunction()) {
+    Nan::ThrowTypeError("Wrong arguments");
+    return;
+  }
+  if (!obj->_slide) {
+    Nan::ThrowError("Slide is not open");
+    return;
+  }
+
+  int64_t maxW = Nan::To<int32_t>(info[0]).FromMaybe(0);
+  int64_t maxH = Nan::To<int32_t>(info[1]).FromMaybe(0);
+  if (maxW <= 0 || maxH <= 0) {
+    Nan::ThrowRangeError("Thumbnail size out of range");
+    return;
+  }
+  int64_t w, h;
+  GetThumbnailSize(*obj->_slide,maxW,maxH,&w,&h);
+  if (!RegionFitsLimit(w,h)) {
+    Nan::ThrowRangeError("Thumbnail size out of range");
+    return;
+  }
+  EncodeOptions encode;
+  if (!ParseEncodeOptions(callbackIndex == 3 ? info[2] : Nan::Undefined().As<v8::Value>(),&encode)) {
+    return;
+  }
+
+  Nan::Callback *callback = new Nan::Callback(info[callbackIndex].As<v8::Function>());
+  Nan::AsyncQueueWorker(new SlideImageWorker(callback,obj->_slide,SlideImageWorker::THUMBNAIL,
+                                             "",w,h,encode));
+}
+
+void OpenSlideObject::ReadAssociatedImage(const Nan::FunctionCallbackInfo<v8::Value>& info) {
+  OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
+
+  int callbackIndex = info.Length() - 1;
+  if (callbackIndex < 1 || callbackIndex > 2 || !info[callbackIndex]->IsFunction()) {
+    Nan::ThrowTypeError("Wrong arguments");
+    return;
+  }
+  if (!obj->_slide) {
+    Nan::ThrowError("Slide is not open");
+    return;
+  }
+
+  Nan::Utf8String val(info[0]);
+  std::string name (*val);
+  std::map<std::string,std::pair<int64_t,int64_t> >::const_iterator it =
+    obj->_slide->associatedImages.find(name);
+  if (it == obj->_slide->associatedImages.end()) {
+    Nan::ThrowRangeError("No such associated image");
+    return;
+  }
+  int64_t w = it->second.first;
+  int64_t h = it->second.second;
+  if (!RegionFitsLimit(w,h)) {
+    Nan::ThrowRangeError("Associated image exceeds the region size limit");
+    return;
+  }
+  EncodeOptions encode;
+  if (!ParseEncodeOptions(callbackIndex == 2 ? info[1] : Nan::Undefined().As<v8::Value>(),&encode)) {
+    return;
+  }
+
+  Nan::Callback *callback = new Nan::Callback(info[callbackIndex].As<v8::Function>());
+  Nan::AsyncQueueWorker(new SlideImageWorker(callback,obj->_slide,SlideImageWorker::ASSOCIATED_IMAGE,
+                                             name,w,h,encode));
 }
 
 void OpenSlideObject::GetPropertyValue(const Nan::FunctionCallbackInfo<v8::Value>& info) {
   OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
-  v8::String::Utf8Value val(info[0]->ToString());
+  Nan::Utf8String val(info[0]);
   std::string propertyName (*val);
-  std::string propertyValue = obj->_properties[propertyName];
+  std::string propertyValue;
+  if (obj->_slide) {
+    std::map<std::string,std::string>::const_iterator it = obj->_slide->properties.find(propertyName);
+    if (it != obj->_slide->properties.end()) {
+      propertyValue = it->second;
+    }
+  }
   info.GetReturnValue().Set(Nan::New(propertyValue).ToLocalChecked());
 }
 
 
 NAN_GETTER(OpenSlideObject::GetLevelCount) {
   OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
-  info.GetReturnValue().Set(Nan::New(obj->_levelCount));
+  info.GetReturnValue().Set(Nan::New(obj->_slide ? obj->_slide->levelCount : 0));
 }
 
 NAN_GETTER(OpenSlideObject::GetLevelWidths) {
   OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
-  std::vector<int64_t> levelWidths = obj->_levelWidths;
+  std::vector<int64_t> levelWidths;
+  if (obj->_slide) {
+    levelWidths = obj->_slide->levelWidths;
+  }
   
   v8::Local<v8::Array> result = Nan::New<v8::Array>(levelWidths.size());
   for ( size_t i = 0; i < levelWidths.size(); i++) {
@@ -155,7 +388,10 @@ NAN_GETTER(OpenSlideObject::GetLevelWidths) {
 
 NAN_GETTER(OpenSlideObject::GetLevelHeights) {
   OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
-  std::vector<int64_t> levelHeights = obj->_levelHeights;
+  std::vector<int64_t> levelHeights;
+  if (obj->_slide) {
+    levelHeights = obj->_slide->levelHeights;
+  }
   
   v8::Local<v8::Array> result = Nan::New<v8::Array>(levelHeights.size());
   for ( size_t i = 0; i < levelHeights.size(); i++) {
@@ -168,7 +404,10 @@ NAN_GETTER(OpenSlideObject::GetLevelHeights) {
 
 NAN_GETTER(OpenSlideObject::GetLevelDownsamples) {
   OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
-  std::vector<double> downsamples = obj->_levelDownsamples;
+  std::vector<double> downsamples;
+  if (obj->_slide) {
+    downsamples = obj->_slide->levelDownsamples;
+  }
   
   v8::Local<v8::Array> result = Nan::New<v8::Array>(downsamples.size());
   for ( size_t i = 0; i < downsamples.size(); i++) {
@@ -181,7 +420,10 @@ NAN_GETTER(OpenSlideObject::GetLevelDownsamples) {
 NAN_GETTER(OpenSlideObject::GetSlidePropertyNames) {
   OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
 
-  std::map<std::string,std::string> pMap = obj->_properties;
+  std::map<std::string,std::string> pMap;
+  if (obj->_slide) {
+    pMap = obj->_slide->properties;
+  }
   v8::Local<v8::Array> result = Nan::New<v8::Array>(pMap.size());
   int i = 0;
   for (map<string,string>::iterator it = pMap.begin(); it != pMap.end(); ++it) {
@@ -189,4 +431,20 @@ NAN_GETTER(OpenSlideObject::GetSlidePropertyNames) {
     i++;
   }
   info.GetReturnValue().Set(result);
+}
+
+NAN_GETTER(OpenSlideObject::GetAssociatedImageNames) {
+  OpenSlideObject *obj = ObjectWrap::Unwrap<OpenSlideObject>(info.Holder());
+
+  std::map<std::string,std::pair<int64_t,int64_t> > images;
+  if (obj->_slide) {
+    images = obj->_slide->associatedImages;
+  }
+  v8::Local<v8::Array> result = Nan::New<v8::Array>(images.size());
+  int i = 0;
+  for (map<string,pair<int64_t,int64_t> >::iterator it = images.begin(); it != images.end(); ++it) {
+    Nan::Set(result,i, Nan::New<String>(it->first).ToLocalChecked());
+    i++;
+  }
+  info.GetReturnValue().Set(result);
 }
\ No newline at end of file
@@ -1,7 +1,13 @@
+#ifndef OPENSLIDEOBJECT_H
+#define OPENSLIDEOBJECT_H
+
 #include <nan.h>
 #include <openslide/openslide.h>
 #include <string>
 #include <map>
+#include <vector>
+#include <memory>
+#include "slide.h"
 
 using namespace std;
 using namespace Nan;
@@ -10,29 +16,39 @@ using namespace v8;
 class OpenSlideObject : public Nan::ObjectWrap {
     public:
         static void Init(v8::Local<v8::Object> exports);
+        static bool HasInstance(v8::Local<v8::Value> value);
+        // Empty until open() succeeds
+        std::shared_ptr<Slide> GetSlide() const { return _slide; }
     private:
         explicit OpenSlideObject(std::string fileName);
         ~OpenSlideObject();
         // Methods
         static Nan::Persistent<v8::Function> constructor;
+        static Nan::Persistent<v8::FunctionTemplate> tmpl;
         static void New(const Nan::FunctionCallbackInfo<v8::Value>& info);
         static void Open(const Nan::FunctionCallbackInfo<v8::Value>& info);
         static void GetPropertyValue(const Nan::FunctionCallbackInfo<v8::Value>& info);
         static void ReadRegion(const Nan::FunctionCallbackInfo<v8::Value>& info);
+        static void ReadRegionAsync(const Nan::FunctionCallbackInfo<v8::Value>& info);
+        static void ReadRegionInto(const Nan::FunctionCallbackInfo<v8::Value>& info);
+        static void ReadRegions(const Nan::FunctionCallbackInfo<v8::Value>& info);
+        static void GetThumbnail(const Nan::FunctionCallbackInfo<v8::Value>& info);
+        static void ReadAssociatedImage(const Nan::FunctionCallbackInfo<v8::Value>& info);
+        // Throws and returns false if the slide is closed or the region is invalid
+        bool CheckRegion(int32_t level, int64_t w, int64_t h);
         // Properties
         static NAN_GETTER(GetLevelCount);
         static NAN_GETTER(GetLevelWidths);
         static NAN_GETTER(GetLevelHeights);
         static NAN_GETTER(GetLevelDownsamples);
         static NAN_GETTER(GetSlidePropertyNames);
+        static NAN_GETTER(GetAssociatedImageNames);
         // Fields
-        openslide_t *_osr;
         std::string _fileName;
-        int32_t _levelCount;
-        std::vector<int64_t> _levelWidths;
-        std::vector<int64_t> _levelHeights;
-        std::vector<double> _levelDownsamples;
-        std::map<std::string,std::string> _properties;
+        // Shared with every other object open on the same path
+        std::shared_ptr<Slide> _slide;
         
 
-};
\ No newline at end of file
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include "parallel.h"
+#include <algorithm>
+
+// The slide registry's default handle budget
+DecodePool decodePool(256);
+
+DecodePool::DecodePool(size_t maxThreads)
+  : _maxThreads(maxThreads), _idle(0), _stopping(false) {
+}
+
+DecodePool::~DecodePool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _wake.notify_all();
+  for (size_t i = 0; i < _threads.size(); i++) {
+    _threads[i].join();
+  }
+}
+
+void DecodePool::Work(Batch *batch) {
+  for (size_t i = batch->next++; i < batch->count; i = batch->next++) {
+    batch->job->Run(i);
+  }
+}
+
+void DecodePool::Run(ParallelJob *job, size_t count, size_t threadCount) {
+  Batch batch;
+  batch.job = job;
+  batch.count = count;
+  batch.next = 0;
+  batch.helpers = std::min(threadCount, count);
+  batch.helpers = batch.helpers > 0 ? batch.helpers - 1 : 0;
+  batch.active = 0;
+
+  bool shared = batch.helpers > 0;
+  if (shared) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _batches.push_back(&batch);
+    // Start threads only for what idle ones cannot cover
+    size_t wanted = batch.helpers > _idle ? batch.helpers - _idle : 0;
+    for (size_t i = 0; i < wanted && _threads.size() < _maxThreads; i++) {
+      _threads.push_back(std::thread(&DecodePool::WorkerLoop, this));
+    }
+    _wake.notify_all();
+  }
+
+  Work(&batch);
+  if (!shared) {
+    return;
+  }
+
+  // No pool thread may pick the batch up once the caller stops waiting
+  std::unique_lock<std::mutex> lock(_mutex);
+  std::deque<Batch *>::iterator it = std::find(_batches.begin(), _batches.end(), &batch);
+  if (it != _batches.end()) {
+    _batches.erase(it);
+  }
+  while (batch.active > 0) {
+    _done.wait(lock);
+  }
+}
+
+void DecodePool::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  for (;;) {
+    while (!_stopping && _batches.empty()) {
+      _idle++;
+      _wake.wait(lock);
+      _idle--;
+    }
+    if (_stopping) {
+      return;
+    }
+    Batch *batch = _batches.front();
+    batch->active++;
+    if (--batch->helpers == 0) {
+      _batches.pop_front();
+    }
+    lock.unlock();
+    Work(batch);
+    lock.lock();
+    if (--batch->active == 0) {
+      _done.notify_all();
+    }
+  }
+}
+
+void DecodePool::SetMaxThreads(size_t maxThreads) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _maxThreads = maxThreads;
+}
+
+size_t DecodePool::Threads() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _threads.size();
+}
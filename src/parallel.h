@@ -0,0 +1,74 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work split by index, for DecodePool
+class ParallelJob {
+    public:
+        virtual ~ParallelJob() {}
+        virtual void Run(size_t index) = 0;
+};
+
+// Persistent threads shared by every parallel read, decode and encode,
+// so none of them pays for thread creation per call. Threads are
+// started as jobs ask for them, up to maxThreads, and then kept. The
+// caller of Run always works on its own job too, so jobs make progress
+// without a free pool thread and may run nested jobs of their own.
+class DecodePool {
+    public:
+        explicit DecodePool(size_t maxThreads);
+        ~DecodePool();
+        // Calls job->Run(i) for every i in [0, count) on up to
+        // threadCount threads, the calling thread included. Indices are
+        // handed out in order. Returns once every call has returned.
+        void Run(ParallelJob *job, size_t count, size_t threadCount);
+        // Existing threads beyond a lowered limit are kept, but idle
+        void SetMaxThreads(size_t maxThreads);
+        size_t Threads();
+    private:
+        struct Batch {
+            ParallelJob *job;
+            size_t count;
+            std::atomic<size_t> next;
+            // Pool threads still wanted, and pool threads working on it
+            size_t helpers;
+            size_t active;
+        };
+        static void Work(Batch *batch);
+        void WorkerLoop();
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        std::condition_variable _done;
+        std::deque<Batch *> _batches;
+        std::vector<std::thread> _threads;
+        size_t _maxThreads;
+        size_t _idle;
+        bool _stopping;
+};
+
+// Sized to the slide registry's handle budget, see SlideRegistry::Configure
+extern DecodePool decodePool;
+
+template <typename Body>
+struct ParallelBody : ParallelJob {
+  Body *body;
+  void Run(size_t index) { (*body)(index); }
+};
+
+// Calls body(i) for every i in [0, count) on up to threadCount threads
+// of the decode pool, the calling thread included. Indices are handed
+// out in order.
+template <typename Body>
+void ParallelFor(size_t count, size_t threadCount, Body body) {
+  ParallelBody<Body> job;
+  job.body = &body;
+  decodePool.Run(&job, count, threadCount);
+}
+
+#endif
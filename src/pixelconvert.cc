@@ -0,0 +1,151 @@
+#include "pixelconvert.h"
+
+// The SSSE3 kernels are compiled for that target alone and picked at
+// run time, so the rest of the addon still runs on any x86 CPU.
+// PIXELCONVERT_SCALAR_ONLY leaves them out, for comparison in tests.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && \
+    !defined(PIXELCONVERT_SCALAR_ONLY)
+#define HAVE_SSSE3_KERNELS
+#include <tmmintrin.h>
+#define SSSE3_TARGET __attribute__((target("ssse3")))
+
+struct CpuFeatures {
+  bool ssse3;
+  CpuFeatures() {
+    // Runs from a static constructor, possibly before libgcc's own
+    __builtin_cpu_init();
+    ssse3 = __builtin_cpu_supports("ssse3") != 0;
+  }
+};
+
+static const CpuFeatures cpu;
+#endif
+
+// 16.16 fixed point 255 / alpha, so un-premultiplying is a multiply
+struct UnpremultiplyTable {
+  uint32_t scale[256];
+  UnpremultiplyTable() {
+    scale[0] = 0;
+    for (uint32_t a = 1; a < 256; a++) {
+      scale[a] = ((255u << 16) + a / 2) / a;
+    }
+  }
+};
+
+static const UnpremultiplyTable unpremultiply;
+
+static inline uint8_t Unpremultiply(uint32_t c, uint32_t scale) {
+  uint32_t v = (c * scale + 0x8000) >> 16;
+  return v > 255 ? 255 : (uint8_t)v;
+}
+
+// Exact x / 255 for x <= 255 * 255
+static inline uint32_t Div255(uint32_t x) {
+  return (x + 1 + (x >> 8)) >> 8;
+}
+
+#if defined(HAVE_SSSE3_KERNELS)
+// Slides are almost entirely opaque, so runs of four opaque pixels
+// only need a byte shuffle. In memory a little-endian ARGB pixel is
+// B, G, R, A.
+SSSE3_TARGET static inline bool Opaque4(__m128i pixels) {
+  const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+  __m128i masked = _mm_and_si128(pixels, alpha);
+  return _mm_movemask_epi8(_mm_cmpeq_epi32(masked, alpha)) == 0xffff;
+}
+
+// Both kernels convert from i while groups of four are opaque and
+// return where they stopped
+SSSE3_TARGET static size_t ArgbToRgbaOpaque(const uint32_t *src, uint8_t *dst,
+                                            size_t i, size_t count) {
+  const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7,
+                                        10, 9, 8, 11, 14, 13, 12, 15);
+  for (; i + 4 <= count; i += 4) {
+    __m128i pixels = _mm_loadu_si128((const __m128i *)(src + i));
+    if (!Opaque4(pixels)) {
+      break;
+    }
+    _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_shuffle_epi8(pixels, shuffle));
+  }
+  return i;
+}
+
+SSSE3_TARGET static size_t ArgbToRgbOpaque(const uint32_t *src, uint8_t *dst,
+                                           size_t i, size_t count) {
+  const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9,
+                                        8, 14, 13, 12, -1, -1, -1, -1);
+  // 12 output bytes per 4 pixels, stored as 8 + 4
+  for (; i + 4 <= count; i += 4) {
+    __m128i pixels = _mm_loadu_si128((const __m128i *)(src + i));
+    if (!Opaque4(pixels)) {
+      break;
+    }
+    __m128i rgb = _mm_shuffle_epi8(pixels, shuffle);
+    uint8_t *out = dst + i * 3;
+    _mm_storel_epi64((__m128i *)out, rgb);
+    uint32_t tail = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(rgb, 8));
+    out[8] = (uint8_t)tail;
+    out[9] = (uint8_t)(tail >> 8);
+    out[10] = (uint8_t)(tail >> 16);
+    out[11] = (uint8_t)(tail >> 24);
+  }
+  return i;
+}
+#endif
+
+// Each loop alternates between the vector path, which stops at the first
+// group holding a translucent pixel, and a scalar pass over that group.
+static inline size_t GroupEnd(size_t i, size_t count) {
+  size_t end = i + 4 - i % 4;
+  return end > count ? count : end;
+}
+
+void ArgbToRgba(const uint32_t *src, uint8_t *dst, size_t count) {
+  size_t i = 0;
+  while (i < count) {
+#if defined(HAVE_SSSE3_KERNELS)
+    if (cpu.ssse3) {
+      i = ArgbToRgbaOpaque(src, dst, i, count);
+    }
+#endif
+    for (size_t end = GroupEnd(i, count); i < end; i++) {
+      uint32_t p = src[i];
+      uint32_t a = p >> 24;
+      uint8_t *out = dst + i * 4;
+      if (a == 255) {
+        out[0] = (uint8_t)(p >> 16);
+        out[1] = (uint8_t)(p >> 8);
+        out[2] = (uint8_t)p;
+      } else {
+        uint32_t scale = unpremultiply.scale[a];
+        out[0] = Unpremultiply((p >> 16) & 0xff, scale);
+        out[1] = Unpremultiply((p >> 8) & 0xff, scale);
+        out[2] = Unpremultiply(p & 0xff, scale);
+      }
+      out[3] = (uint8_t)a;
+    }
+  }
+}
+
+void ArgbToRgb(const uint32_t *src, uint8_t *dst, size_t count, uint32_t background) {
+  uint32_t bgR = (background >> 16) & 0xff;
+  uint32_t bgG = (background >> 8) & 0xff;
+  uint32_t bgB = background & 0xff;
+
+  size_t i = 0;
+  while (i < count) {
+#if defined(HAVE_SSSE3_KERNELS)
+    if (cpu.ssse3) {
+      i = ArgbToRgbOpaque(src, dst, i, count);
+    }
+#endif
+    for (size_t end = GroupEnd(i, count); i < end; i++) {
+      uint32_t p = src[i];
+      uint32_t inverse = 255 - (p >> 24);
+      uint8_t *out = dst + i * 3;
+      out[0] = (uint8_t)(((p >> 16) & 0xff) + Div255(bgR * inverse));
+      out[1] = (uint8_t)(((p >> 8) & 0xff) + Div255(bgG * inverse));
+      out[2] = (uint8_t)((p & 0xff) + Div255(bgB * inverse));
+    }
+  }
+}
@@ -0,0 +1,17 @@
+#ifndef PIXELCONVERT_H
+#define PIXELCONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Conversions from openslide's premultiplied ARGB (one native-endian
+// uint32_t per pixel) to the byte orders image encoders expect.
+
+// Straight (un-premultiplied) RGBA, 4 bytes per pixel
+void ArgbToRgba(const uint32_t *src, uint8_t *dst, size_t count);
+
+// RGB composited over background (0xRRGGBB), 3 bytes per pixel.
+// Premultiplied pixels composite with one multiply-add, no division.
+void ArgbToRgb(const uint32_t *src, uint8_t *dst, size_t count, uint32_t background);
+
+#endif
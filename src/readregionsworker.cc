@@ -0,0 +1,158 @@
+#include "readregionsworker.h"
+#include "parallel.h"
+#include "tilecache.h"
+#include <algorithm>
+#include <string.h>
+
+// Orders requests by level, then row, then column
+struct RequestOrder {
+  const std::vector<Region> *requests;
+  bool operator()(size_t a, size_t b) const {
+    const Region &ra = (*requests)[a];
+    const Region &rb = (*requests)[b];
+    if (ra.level != rb.level) return ra.level < rb.level;
+    if (ra.y != rb.y) return ra.y < rb.y;
+    if (ra.x != rb.x) return ra.x < rb.x;
+    if (ra.w != rb.w) return ra.w < rb.w;
+    return ra.h < rb.h;
+  }
+};
+
+// Encodes and caches the k-th decoded region
+struct EncodeRegion {
+  const std::string *slide;
+  const std::vector<size_t> *indices;
+  const std::vector<Region> *regions;
+  std::vector<EncodedResult> *results;
+  const EncodeOptions *options;
+  std::vector<std::string> *errors;
+  void operator()(size_t k) {
+    size_t i = (*indices)[k];
+    const Region &region = (*regions)[i];
+    EncodedResult &result = (*results)[i];
+    if (result.Encode(region.w,region.h,*options,&(*errors)[i])) {
+      tileCache.Put(RegionTileKey(*slide,region.level,region.x,region.y,region.w,region.h,*options),
+                    result.Data(),result.Size());
+    }
+  }
+};
+
+static bool SameRegion(const Region &a, const Region &b) {
+  return a.level == b.level && a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+ReadRegionsWorker::ReadRegionsWorker(Nan::Callback *callback, std::shared_ptr<Slide> slide,
+                                     const std::vector<Region> &requests,
+                                     const EncodeOptions &encode)
+  : Nan::AsyncWorker(callback), _slide(slide), _micros(0), _requests(requests),
+    _encode(encode) {
+}
+
+void ReadRegionsWorker::Execute() {
+  OperationTimer timer(&_micros);
+  std::vector<size_t> order(_requests.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  RequestOrder compare = { &_requests };
+  std::sort(order.begin(),order.end(),compare);
+
+  // Collapse duplicates, which are adjacent once sorted
+  _requestRegion.resize(_requests.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    const Region &request = _requests[order[i]];
+    if (_regions.empty() || !SameRegion(_regions.back(),request)) {
+      _regions.push_back(request);
+    }
+    _requestRegion[order[i]] = _regions.size() - 1;
+  }
+
+  // Serve what the tile cache has, collect the rest
+  bool raw = _encode.format == FORMAT_RAW;
+  bool cacheable = !raw || tileCache.CacheRaw();
+  std::vector<EncodedResult>(_regions.size()).swap(_results);
+  std::vector<size_t> misses;
+  for (size_t i = 0; i < _regions.size(); i++) {
+    const Region &region = _regions[i];
+    TileData cached = cacheable ?
+      tileCache.Get(RegionTileKey(_slide->fileName,region.level,region.x,
+                                  region.y,region.w,region.h,_encode)) : TileData();
+    if (cached && !raw) {
+      if (!_results[i].CopyEncoded(cached)) {
+        SetErrorMessage("Out of memory");
+        return;
+      }
+      continue;
+    }
+    if (!_results[i].Acquire(region.w * region.h * 4)) {
+      SetErrorMessage("Out of memory");
+      return;
+    }
+    if (cached) {
+      memcpy(_results[i].Pixels(),&(*cached)[0],_results[i].Size());
+    } else {
+      misses.push_back(i);
+    }
+  }
+  if (misses.empty()) {
+    return;
+  }
+
+  std::vector<Region> missRegions(misses.size());
+  std::vector<uint32_t *> missData(misses.size());
+  for (size_t k = 0; k < misses.size(); k++) {
+    missRegions[k] = _regions[misses[k]];
+    missData[k] = _results[misses[k]].Pixels();
+  }
+  std::string error;
+  if (!ReadRegions(_slide.get(),missRegions,missData,&error)) {
+    SetErrorMessage(error.c_str());
+    return;
+  }
+
+  if (raw) {
+    for (size_t k = 0; k < misses.size() && cacheable; k++) {
+      const Region &region = missRegions[k];
+      tileCache.Put(RegionTileKey(_slide->fileName,region.level,region.x,region.y,
+                                  region.w,region.h,_encode),
+                    (const char *)missData[k],region.w * region.h * 4);
+    }
+    return;
+  }
+
+  std::vector<std::string> errors(_regions.size());
+  EncodeRegion encode = { &_slide->fileName, &misses, &_regions, &_results,
+                          &_encode, &errors };
+  ParallelFor(misses.size(),_slide->handles.MaxHandles(),encode);
+  for (size_t i = 0; i < errors.size(); i++) {
+    if (!errors[i].empty()) {
+      SetErrorMessage(errors[i].c_str());
+      return;
+    }
+  }
+}
+
+void ReadRegionsWorker::HandleOKCallback() {
+  Nan::HandleScope scope;
+
+  std::vector<v8::Local<v8::Object> > buffers(_regions.size());
+  uint64_t bytes = 0;
+  for (size_t i = 0; i < _regions.size(); i++) {
+    bytes += _results[i].Size();
+    buffers[i] = _results[i].ToBuffer();
+  }
+
+  v8::Local<v8::Array> result = Nan::New<v8::Array>(_requests.size());
+  for (size_t i = 0; i < _requests.size(); i++) {
+    Nan::Set(result,i,buffers[_requestRegion[i]]);
+  }
+  _slide->stats->RecordCall(OP_READ_REGIONS,_micros,bytes);
+
+  v8::Local<v8::Value> argv[] = { Nan::Null(), result };
+  callback->Call(2, argv);
+}
+
+void ReadRegionsWorker::HandleErrorCallback() {
+  _slide->stats->RecordError(OP_READ_REGIONS,_micros);
+  Nan::AsyncWorker::HandleErrorCallback();
+}
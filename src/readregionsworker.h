@@ -0,0 +1,37 @@
+#ifndef READREGIONSWORKER_H
+#define READREGIONSWORKER_H
+
+#include <nan.h>
+#include <memory>
+#include <vector>
+#include "encodedresult.h"
+#include "encoder.h"
+#include "regionreader.h"
+#include "slide.h"
+
+// Decodes a batch of regions of one slide on the libuv thread pool and
+// calls back with an array of Buffers in request order. Duplicate
+// requests are decoded once and share a Buffer; the rest are sorted by
+// level and position so neighbouring reads hit the same TIFF tiles.
+// With encode options set, each Buffer holds an encoded image instead.
+class ReadRegionsWorker : public Nan::AsyncWorker {
+    public:
+        ReadRegionsWorker(Nan::Callback *callback, std::shared_ptr<Slide> slide,
+                          const std::vector<Region> &requests,
+                          const EncodeOptions &encode);
+        void Execute();
+        void HandleOKCallback();
+        void HandleErrorCallback();
+    private:
+        std::shared_ptr<Slide> _slide;
+        uint64_t _micros;
+        std::vector<Region> _requests;
+        // Index into _regions for each request
+        std::vector<size_t> _requestRegion;
+        std::vector<Region> _regions;
+        // One per region, handed over to JS in HandleOKCallback
+        std::vector<EncodedResult> _results;
+        EncodeOptions _encode;
+};
+
+#endif
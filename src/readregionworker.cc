@@ -0,0 +1,81 @@
+#include "readregionworker.h"
+#include "regionreader.h"
+#include "tilecache.h"
+
+ReadRegionWorker::ReadRegionWorker(Nan::Callback *callback, std::shared_ptr<Slide> slide,
+                                   int32_t level, int64_t x, int64_t y, int64_t w, int64_t h,
+                                   char *dest)
+  : Nan::AsyncWorker(callback), _slide(slide), _micros(0), _level(level),
+    _x(x), _y(y), _w(w), _h(h), _dest(dest) {
+  DefaultEncodeOptions(&_encode);
+}
+
+void ReadRegionWorker::SetEncodeOptions(const EncodeOptions &options) {
+  _encode = options;
+}
+
+void ReadRegionWorker::Execute() {
+  OperationTimer timer(&_micros);
+  std::string error;
+  if (_dest != NULL) {
+    // JS still holds the Buffer and may write to it while this runs, so
+    // it is never copied into the shared cache
+    if (!ReadRegionCached(_slide.get(),(uint32_t *)_dest,_x,_y,_level,_w,_h,false,&error)) {
+      SetErrorMessage(error.c_str());
+    }
+    return;
+  }
+
+  if (_encode.format != FORMAT_RAW) {
+    // Encoded output is cached as such, the raw pixels are not kept
+    TileKey key = RegionTileKey(_slide->fileName,_level,_x,_y,_w,_h,_encode);
+    TileData cached = tileCache.Get(key);
+    if (cached) {
+      if (!_result.CopyEncoded(cached)) {
+        SetErrorMessage("Out of memory");
+      }
+      return;
+    }
+
+    if (!_result.Acquire(_w * _h * 4)) {
+      SetErrorMessage("Out of memory");
+      return;
+    }
+    if (!ReadRegionTiled(_slide.get(),_result.Pixels(),_x,_y,_level,_w,_h,&error) ||
+        !_result.Encode(_w,_h,_encode,&error)) {
+      SetErrorMessage(error.c_str());
+      return;
+    }
+    tileCache.Put(key,_result.Data(),_result.Size());
+    return;
+  }
+
+  if (!_result.Acquire(_w * _h * 4)) {
+    SetErrorMessage("Out of memory");
+    return;
+  }
+  if (!ReadRegionCached(_slide.get(),_result.Pixels(),_x,_y,_level,_w,_h,true,&error)) {
+    SetErrorMessage(error.c_str());
+  }
+}
+
+void ReadRegionWorker::HandleOKCallback() {
+  Nan::HandleScope scope;
+
+  v8::Local<v8::Value> buffer;
+  if (_dest != NULL) {
+    _slide->stats->RecordCall(OP_READ_REGION,_micros,_w * _h * 4);
+    buffer = GetFromPersistent("buffer");
+  } else {
+    _slide->stats->RecordCall(OP_READ_REGION,_micros,_result.Size());
+    buffer = _result.ToBuffer();
+  }
+
+  v8::Local<v8::Value> argv[] = { Nan::Null(), buffer };
+  callback->Call(2, argv);
+}
+
+void ReadRegionWorker::HandleErrorCallback() {
+  _slide->stats->RecordError(OP_READ_REGION,_micros);
+  Nan::AsyncWorker::HandleErrorCallback();
+}
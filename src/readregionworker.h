@@ -0,0 +1,41 @@
+#ifndef READREGIONWORKER_H
+#define READREGIONWORKER_H
+
+#include <nan.h>
+#include <openslide/openslide.h>
+#include <memory>
+#include "encodedresult.h"
+#include "encoder.h"
+#include "slide.h"
+
+// Decodes one region on the libuv thread pool and hands the pixels
+// back to JS as a Buffer of premultiplied ARGB. Holding the slide keeps
+// it, and its handles, out of registry eviction until the read is done.
+// When dest is given the pixels are written there directly; the caller
+// must keep the owning Buffer alive (SaveToPersistent "buffer") until
+// the callback runs. Otherwise the pixels can be encoded to JPEG or PNG
+// on the worker, see SetEncodeOptions.
+class ReadRegionWorker : public Nan::AsyncWorker {
+    public:
+        ReadRegionWorker(Nan::Callback *callback, std::shared_ptr<Slide> slide,
+                         int32_t level, int64_t x, int64_t y, int64_t w, int64_t h,
+                         char *dest = NULL);
+        // Not supported together with dest
+        void SetEncodeOptions(const EncodeOptions &options);
+        void Execute();
+        void HandleOKCallback();
+        void HandleErrorCallback();
+    private:
+        std::shared_ptr<Slide> _slide;
+        uint64_t _micros;
+        int32_t _level;
+        int64_t _x;
+        int64_t _y;
+        int64_t _w;
+        int64_t _h;
+        char *_dest;
+        EncodeOptions _encode;
+        EncodedResult _result;
+};
+
+#endif
@@ -0,0 +1,265 @@
+#include "regionreader.h"
+#include "parallel.h"
+#include "resample.h"
+#include "tilecache.h"
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+static const int64_t STRIP_HEIGHT = 256;
+// Below this many pixels a second thread costs more than it saves
+static const int64_t MIN_PARALLEL_PIXELS = 512 * 512;
+
+static std::atomic<size_t> maxRegionBytes(256 * 1024 * 1024);
+
+size_t GetMaxRegionBytes() {
+  return maxRegionBytes;
+}
+
+void SetMaxRegionBytes(size_t bytes) {
+  maxRegionBytes = bytes;
+}
+
+bool RegionFitsLimit(int64_t w, int64_t h) {
+  // Dividing the limit instead of multiplying the size cannot overflow
+  return w > 0 && h > 0 && (uint64_t)w <= GetMaxRegionBytes() / 4 / (uint64_t)h;
+}
+
+// First error wins and stops the remaining work
+struct ReadStatus {
+  std::atomic<bool> failed;
+  std::mutex errorMutex;
+  std::string error;
+};
+
+static void Fail(ReadStatus *status, const char *error) {
+  std::lock_guard<std::mutex> lock(status->errorMutex);
+  if (!status->failed) {
+    status->error = error;
+    status->failed = true;
+  }
+}
+
+struct TiledRead : ReadStatus {
+  Slide *slide;
+  double downsample;
+  uint32_t *dest;
+  int64_t x;
+  int64_t y;
+  int32_t level;
+  int64_t w;
+  int64_t h;
+  int64_t strips;
+  std::atomic<int64_t> nextStrip;
+};
+
+static void ReadStrips(TiledRead *read) {
+  openslide_t *osr = read->slide->handles.Acquire();
+  if (osr == NULL) {
+    Fail(read, "Cannot open slide");
+    return;
+  }
+
+  while (!read->failed) {
+    int64_t strip = read->nextStrip++;
+    if (strip >= read->strips) {
+      break;
+    }
+    int64_t row = strip * STRIP_HEIGHT;
+    int64_t rows = std::min(STRIP_HEIGHT, read->h - row);
+    // Strips start at whole level rows, expressed in level 0 coordinates
+    int64_t stripY = read->y + (int64_t)(row * read->downsample);
+    uint64_t start = NowMicros();
+    openslide_read_region(osr, read->dest + row * read->w,
+                          read->x, stripY, read->level, read->w, rows);
+    read->slide->stats->RecordDecode(NowMicros() - start, read->w * rows);
+    const char *error = openslide_get_error(osr);
+    if (error != NULL) {
+      Fail(read, error);
+      break;
+    }
+  }
+
+  read->slide->handles.Release(osr);
+}
+
+// One share of the strips per participating thread, each on one handle
+struct StripReader {
+  TiledRead *read;
+  void operator()(size_t) { ReadStrips(read); }
+};
+
+bool ReadRegionTiled(Slide *slide, uint32_t *dest,
+                     int64_t x, int64_t y, int32_t level, int64_t w, int64_t h,
+                     std::string *error) {
+  TiledRead read;
+  read.slide = slide;
+  read.downsample = slide->levelDownsamples[level];
+  read.dest = dest;
+  read.x = x;
+  read.y = y;
+  read.level = level;
+  read.w = w;
+  read.h = h;
+  read.strips = (h + STRIP_HEIGHT - 1) / STRIP_HEIGHT;
+  read.nextStrip = 0;
+  read.failed = false;
+
+  size_t threadCount = 1;
+  if (w * h >= MIN_PARALLEL_PIXELS) {
+    threadCount = std::min((size_t)read.strips, slide->handles.MaxHandles());
+  }
+
+  // The calling thread takes a share of the strips too
+  StripReader reader = { &read };
+  ParallelFor(threadCount, threadCount, reader);
+
+  if (read.failed) {
+    *error = read.error;
+    return false;
+  }
+  return true;
+}
+
+bool ReadRegionCached(Slide *slide, uint32_t *dest,
+                      int64_t x, int64_t y, int32_t level, int64_t w, int64_t h,
+                      bool fillCache, std::string *error) {
+  if (!tileCache.CacheRaw()) {
+    return ReadRegionTiled(slide, dest, x, y, level, w, h, error);
+  }
+  EncodeOptions raw;
+  DefaultEncodeOptions(&raw);
+  TileKey key = RegionTileKey(slide->fileName, level, x, y, w, h, raw);
+  TileData cached = tileCache.Get(key);
+  if (cached) {
+    memcpy(dest, &(*cached)[0], cached->size());
+    return true;
+  }
+
+  if (!ReadRegionTiled(slide, dest, x, y, level, w, h, error)) {
+    return false;
+  }
+  if (fillCache) {
+    tileCache.Put(key, (const char *)dest, w * h * 4);
+  }
+  return true;
+}
+
+// Source pixels read per band of ReadRegionScaled: at most a strip of
+// ReadRegionTiled, and no more than 16 MB (or the region limit) for
+// wide levels
+static const int64_t BAND_SOURCE_ROWS = 256;
+static const int64_t BAND_SOURCE_BYTES = 16 * 1024 * 1024;
+
+// Reads the source rows under one band of output rows and scales them
+// into dest. Bands share no output rows, so they can run in parallel.
+struct ScaledBand {
+  Slide *slide;
+  const AreaResampler *resampler;
+  int64_t x;
+  int64_t y;
+  int32_t level;
+  int64_t sourceWidth;
+  int64_t bandRows;
+  int64_t w;
+  int64_t h;
+  uint32_t *dest;
+  std::vector<std::string> *errors;
+  void operator()(size_t band) {
+    int64_t y0 = band * bandRows;
+    int64_t y1 = std::min(y0 + bandRows, h);
+    int64_t first, last;
+    resampler->SourceRows(y0, y1, &first, &last);
+    if ((uint64_t)sourceWidth * (uint64_t)(last - first) * 4 > GetMaxRegionBytes()) {
+      (*errors)[band] = "Region too large to scale";
+      return;
+    }
+    std::vector<uint32_t> pixels(sourceWidth * (last - first));
+    int64_t bandY = y + (int64_t)(first * slide->levelDownsamples[level]);
+    if (ReadRegionTiled(slide, &pixels[0], x, bandY, level, sourceWidth, last - first,
+                        &(*errors)[band])) {
+      resampler->Resample(&pixels[0], y0, y1, dest + y0 * w);
+    }
+  }
+};
+
+bool ReadRegionScaled(Slide *slide, uint32_t *dest,
+                      int64_t x, int64_t y, int32_t level, int64_t w, int64_t h,
+                      int64_t dw, int64_t dh, std::string *error) {
+  AreaResampler resampler(w, h, dw, dh);
+  int64_t bandBytes = std::min(BAND_SOURCE_BYTES, (int64_t)GetMaxRegionBytes());
+  int64_t sourceRows = std::min(BAND_SOURCE_ROWS, bandBytes / (w * 4));
+  int64_t bandRows = std::max((int64_t)1, sourceRows * dh / h);
+  size_t bands = (size_t)((dh + bandRows - 1) / bandRows);
+  std::vector<std::string> errors(bands);
+  ScaledBand body = { slide, &resampler, x, y, level, w, bandRows, dw, dh, dest, &errors };
+  ParallelFor(bands, slide->handles.MaxHandles(), body);
+  for (size_t i = 0; i < errors.size(); i++) {
+    if (!errors[i].empty()) {
+      *error = errors[i];
+      return false;
+    }
+  }
+  return true;
+}
+
+struct BatchRead : ReadStatus {
+  Slide *slide;
+  const std::vector<Region> *regions;
+  const std::vector<uint32_t *> *dests;
+  std::atomic<size_t> next;
+};
+
+static void ReadBatch(BatchRead *read) {
+  openslide_t *osr = read->slide->handles.Acquire();
+  if (osr == NULL) {
+    Fail(read, "Cannot open slide");
+    return;
+  }
+
+  while (!read->failed) {
+    size_t i = read->next++;
+    if (i >= read->regions->size()) {
+      break;
+    }
+    const Region &region = (*read->regions)[i];
+    uint64_t start = NowMicros();
+    openslide_read_region(osr, (*read->dests)[i], region.x, region.y,
+                          region.level, region.w, region.h);
+    read->slide->stats->RecordDecode(NowMicros() - start, region.w * region.h);
+    const char *error = openslide_get_error(osr);
+    if (error != NULL) {
+      Fail(read, error);
+      break;
+    }
+  }
+
+  read->slide->handles.Release(osr);
+}
+
+struct BatchReader {
+  BatchRead *read;
+  void operator()(size_t) { ReadBatch(read); }
+};
+
+bool ReadRegions(Slide *slide, const std::vector<Region> &regions,
+                 const std::vector<uint32_t *> &dests, std::string *error) {
+  BatchRead read;
+  read.slide = slide;
+  read.regions = &regions;
+  read.dests = &dests;
+  read.next = 0;
+  read.failed = false;
+
+  size_t threadCount = std::min(regions.size(), slide->handles.MaxHandles());
+  BatchReader reader = { &read };
+  ParallelFor(threadCount, threadCount, reader);
+
+  if (read.failed) {
+    *error = read.error;
+    return false;
+  }
+  return true;
+}
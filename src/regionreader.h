@@ -0,0 +1,59 @@
+#ifndef REGIONREADER_H
+#define REGIONREADER_H
+
+#include <openslide/openslide.h>
+#include <string>
+#include <vector>
+#include "handlepool.h"
+#include "slide.h"
+
+struct Region {
+  int32_t level;
+  int64_t x;
+  int64_t y;
+  int64_t w;
+  int64_t h;
+};
+
+// Largest region, in bytes of ARGB output, a single read may produce
+size_t GetMaxRegionBytes();
+void SetMaxRegionBytes(size_t bytes);
+// Whether w and h are positive and w x h ARGB pixels fit in
+// GetMaxRegionBytes, exactly and without overflow for any w and h
+bool RegionFitsLimit(int64_t w, int64_t h);
+
+// Reads a region of any size into dest (w * h pixels). Large regions
+// are cut into full-width strips that map onto contiguous rows of dest
+// and are decoded concurrently, each thread on its own pooled handle.
+// x and y are level 0 coordinates. Each openslide_read_region call is
+// timed into slide->stats. Returns false and sets error on failure.
+bool ReadRegionTiled(Slide *slide, uint32_t *dest,
+                     int64_t x, int64_t y, int32_t level, int64_t w, int64_t h,
+                     std::string *error);
+
+// ReadRegionTiled through the shared tile cache, if it caches raw
+// regions: a cached region is copied into dest, otherwise it is decoded
+// and, with fillCache and if small enough, cached. The entry is copied from dest, so only fill the
+// cache when nothing else can write to dest during the call; memory the
+// caller owns, such as a JS Buffer, could change under the copy.
+bool ReadRegionCached(Slide *slide, uint32_t *dest,
+                      int64_t x, int64_t y, int32_t level, int64_t w, int64_t h,
+                      bool fillCache, std::string *error);
+
+// Reads a region of w x h level pixels and scales it to dw x dh into dest
+// with an area filter. The region is read in bands of rows, in parallel,
+// and each band is scaled as it arrives, so only dest has to fit in
+// memory. Fails if the source rows under a single output row exceed
+// GetMaxRegionBytes.
+bool ReadRegionScaled(Slide *slide, uint32_t *dest,
+                      int64_t x, int64_t y, int32_t level, int64_t w, int64_t h,
+                      int64_t dw, int64_t dh, std::string *error);
+
+// Reads each region into the matching entry of dests. Regions are shared
+// out across threads, each with its own pooled handle, in the order
+// given, so callers should sort them for locality. Returns false and
+// sets error if any read fails.
+bool ReadRegions(Slide *slide, const std::vector<Region> &regions,
+                 const std::vector<uint32_t *> &dests, std::string *error);
+
+#endif
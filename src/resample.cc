@@ -0,0 +1,113 @@
+#include "resample.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Source pixels covering each output pixel along one axis
+void AreaResampler::ComputeContributions(int64_t srcSize, int64_t dstSize,
+                                         std::vector<Contribution> *contributions) {
+  double scale = (double)srcSize / dstSize;
+  contributions->resize(dstSize);
+  for (int64_t i = 0; i < dstSize; i++) {
+    double begin = i * scale;
+    double end = std::min((i + 1) * scale, (double)srcSize);
+    int64_t first = (int64_t)begin;
+    int64_t last = std::min((int64_t)std::ceil(end), srcSize);
+    Contribution &contribution = (*contributions)[i];
+    contribution.start = first;
+    contribution.weights.clear();
+    for (int64_t j = first; j < last; j++) {
+      double covered = std::min(end, (double)(j + 1)) - std::max(begin, (double)j);
+      contribution.weights.push_back((float)(covered / (end - begin)));
+    }
+  }
+}
+
+// Averages each 2x2 block. Channels are summed two at a time in the
+// 16 bit halves of a word, which cannot overflow for four pixels.
+static void Halve(const uint32_t *src, int64_t sw, uint32_t *dst, int64_t dw, int64_t dh) {
+  for (int64_t y = 0; y < dh; y++) {
+    const uint32_t *row0 = src + 2 * y * sw;
+    const uint32_t *row1 = row0 + sw;
+    uint32_t *out = dst + y * dw;
+    for (int64_t x = 0; x < dw; x++) {
+      uint32_t a = row0[2 * x], b = row0[2 * x + 1];
+      uint32_t c = row1[2 * x], d = row1[2 * x + 1];
+      uint32_t rb = (a & 0x00ff00ff) + (b & 0x00ff00ff) +
+                    (c & 0x00ff00ff) + (d & 0x00ff00ff) + 0x00020002;
+      uint32_t ag = ((a >> 8) & 0x00ff00ff) + ((b >> 8) & 0x00ff00ff) +
+                    ((c >> 8) & 0x00ff00ff) + ((d >> 8) & 0x00ff00ff) + 0x00020002;
+      out[x] = ((rb >> 2) & 0x00ff00ff) | (((ag >> 2) & 0x00ff00ff) << 8);
+    }
+  }
+}
+
+static inline uint32_t Pack(float value) {
+  int32_t v = (int32_t)(value + 0.5f);
+  return v < 0 ? 0 : (v > 255 ? 255 : (uint32_t)v);
+}
+
+AreaResampler::AreaResampler(int64_t sw, int64_t sh, int64_t dw, int64_t dh)
+  : _sw(sw), _dw(dw), _halve(sw == 2 * dw && sh == 2 * dh) {
+  if (!_halve) {
+    ComputeContributions(sw, dw, &_columns);
+    ComputeContributions(sh, dh, &_rows);
+  }
+}
+
+void AreaResampler::SourceRows(int64_t y0, int64_t y1, int64_t *first, int64_t *last) const {
+  if (_halve) {
+    *first = 2 * y0;
+    *last = 2 * y1;
+    return;
+  }
+  *first = _rows[y0].start;
+  *last = _rows[y1 - 1].start + _rows[y1 - 1].weights.size();
+}
+
+void AreaResampler::Resample(const uint32_t *src, int64_t y0, int64_t y1, uint32_t *dst) const {
+  if (_halve) {
+    Halve(src, _sw, dst, _dw, y1 - y0);
+    return;
+  }
+
+  // One output row at a time: blend the source rows under it into a
+  // float row, then reduce that row horizontally
+  int64_t first = _rows[y0].start;
+  std::vector<float> row(_sw * 4);
+  for (int64_t y = y0; y < y1; y++) {
+    const Contribution &rowContribution = _rows[y];
+    std::fill(row.begin(), row.end(), 0.0f);
+    for (size_t k = 0; k < rowContribution.weights.size(); k++) {
+      const uint32_t *line = src + (rowContribution.start - first + k) * _sw;
+      float weight = rowContribution.weights[k];
+      for (int64_t x = 0; x < _sw; x++) {
+        uint32_t p = line[x];
+        row[4 * x] += weight * (p >> 24);
+        row[4 * x + 1] += weight * ((p >> 16) & 0xff);
+        row[4 * x + 2] += weight * ((p >> 8) & 0xff);
+        row[4 * x + 3] += weight * (p & 0xff);
+      }
+    }
+
+    uint32_t *out = dst + (y - y0) * _dw;
+    for (int64_t x = 0; x < _dw; x++) {
+      const Contribution &column = _columns[x];
+      float a = 0, r = 0, g = 0, b = 0;
+      const float *in = &row[4 * column.start];
+      for (size_t k = 0; k < column.weights.size(); k++) {
+        float weight = column.weights[k];
+        a += weight * in[4 * k];
+        r += weight * in[4 * k + 1];
+        g += weight * in[4 * k + 2];
+        b += weight * in[4 * k + 3];
+      }
+      out[x] = (Pack(a) << 24) | (Pack(r) << 16) | (Pack(g) << 8) | Pack(b);
+    }
+  }
+}
+
+void ResampleArea(const uint32_t *src, int64_t sw, int64_t sh,
+                  uint32_t *dst, int64_t dw, int64_t dh) {
+  AreaResampler(sw, sh, dw, dh).Resample(src, 0, dh, dst);
+}
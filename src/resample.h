@@ -0,0 +1,40 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include <stdint.h>
+#include <vector>
+
+// Scales premultiplied ARGB from sw x sh to dw x dh with an area (box)
+// filter: every output pixel is the coverage-weighted mean of the
+// source pixels under it. Averaging premultiplied values keeps edges
+// against transparent areas clean. Exact 2:1 reductions take a faster
+// integer path.
+void ResampleArea(const uint32_t *src, int64_t sw, int64_t sh,
+                  uint32_t *dst, int64_t dw, int64_t dh);
+
+// The same filter for sources too large to hold at once: output rows
+// are produced in bands from just the source rows under them, so bands
+// can be read and scaled independently
+class AreaResampler {
+    public:
+        AreaResampler(int64_t sw, int64_t sh, int64_t dw, int64_t dh);
+        // Source rows [*first, *last) covered by output rows [y0, y1)
+        void SourceRows(int64_t y0, int64_t y1, int64_t *first, int64_t *last) const;
+        // Writes output rows [y0, y1) to dst, from src starting at the
+        // first source row SourceRows gives for them
+        void Resample(const uint32_t *src, int64_t y0, int64_t y1, uint32_t *dst) const;
+    private:
+        struct Contribution {
+          int64_t start;
+          std::vector<float> weights;
+        };
+        static void ComputeContributions(int64_t srcSize, int64_t dstSize,
+                                         std::vector<Contribution> *contributions);
+        int64_t _sw;
+        int64_t _dw;
+        bool _halve;
+        std::vector<Contribution> _columns;
+        std::vector<Contribution> _rows;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#include "slide.h"
+
+Slide::Slide(const std::string &fileName, openslide_t *osr, size_t maxHandles,
+             HandleBudget *budget)
+  : fileName(fileName), stats(slideStats.ForFile(fileName)),
+    handles(fileName, osr, maxHandles, budget) {
+  // Store level count
+  levelCount = openslide_get_level_count(osr);
+
+  // Store dimensions
+  for (int i = 0; i < levelCount; i++) {
+    int64_t w, h;
+    openslide_get_level_dimensions(osr,i,&w,&h);
+    levelWidths.push_back(w);
+    levelHeights.push_back(h);
+    levelDownsamples.push_back(openslide_get_level_downsample(osr,i));
+  }
+
+  // Properties
+  const char* const *pNames = openslide_get_property_names(osr);
+  int i = 0;
+  while (pNames[i] != 0) {
+    const char *pValue = openslide_get_property_value(osr,pNames[i]);
+    properties[pNames[i]] = pValue;
+    i++;
+  }
+
+  // Associated images
+  const char* const *aNames = openslide_get_associated_image_names(osr);
+  for (i = 0; aNames[i] != 0; i++) {
+    int64_t w, h;
+    openslide_get_associated_image_dimensions(osr,aNames[i],&w,&h);
+    associatedImages[aNames[i]] = std::make_pair(w,h);
+  }
+}
+
+int32_t Slide::BestLevelForDownsample(double downsample) const {
+  for (int32_t i = 1; i < levelCount; i++) {
+    if (downsample < levelDownsamples[i]) {
+      return i - 1;
+    }
+  }
+  return levelCount - 1;
+}
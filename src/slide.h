@@ -0,0 +1,40 @@
+#ifndef SLIDE_H
+#define SLIDE_H
+
+#include <openslide/openslide.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "handlepool.h"
+#include "slidestats.h"
+
+// Everything known about one slide file: metadata read once at open
+// time and the pool of handles reads go through. Shared by all JS
+// objects on the same path via the SlideRegistry; immutable after
+// construction apart from the pool, which does its own locking.
+class Slide {
+    public:
+        // Takes ownership of osr, which seeds the handle pool and must
+        // already be charged to budget
+        Slide(const std::string &fileName, openslide_t *osr, size_t maxHandles,
+              HandleBudget *budget = NULL);
+        // Same choice as openslide_get_best_level_for_downsample, without
+        // needing a handle
+        int32_t BestLevelForDownsample(double downsample) const;
+        std::string fileName;
+        int32_t levelCount;
+        std::vector<int64_t> levelWidths;
+        std::vector<int64_t> levelHeights;
+        std::vector<double> levelDownsamples;
+        std::map<std::string,std::string> properties;
+        // Label, macro and similar images, name to width and height
+        std::map<std::string,std::pair<int64_t,int64_t> > associatedImages;
+        // Shared with any later Slide on the same path, see SlideStatsTable
+        std::shared_ptr<SlideStats> stats;
+        HandlePool handles;
+    private:
+        Slide(const Slide &);
+        Slide &operator=(const Slide &);
+};
+
+#endif
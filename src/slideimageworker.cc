@@ -0,0 +1,51 @@
+#include "slideimageworker.h"
+#include "thumbnail.h"
+
+SlideImageWorker::SlideImageWorker(Nan::Callback *callback, std::shared_ptr<Slide> slide,
+                                   Kind kind, const std::string &name, int64_t w, int64_t h,
+                                   const EncodeOptions &options)
+  : Nan::AsyncWorker(callback), _slide(slide), _micros(0), _kind(kind), _name(name), _w(w), _h(h),
+    _options(options) {
+}
+
+SlideOperation SlideImageWorker::Operation() const {
+  return _kind == THUMBNAIL ? OP_THUMBNAIL : OP_ASSOCIATED_IMAGE;
+}
+
+void SlideImageWorker::Execute() {
+  OperationTimer timer(&_micros);
+  if (!_result.Acquire(_w * _h * 4)) {
+    SetErrorMessage("Out of memory");
+    return;
+  }
+
+  std::string error;
+  bool ok;
+  if (_kind == THUMBNAIL) {
+    ok = ReadThumbnail(_slide.get(),_w,_h,_result.Pixels(),&error);
+  } else {
+    ok = ReadAssociatedImage(_slide.get(),_name,_result.Pixels(),&error);
+  }
+  if (!ok || !_result.Encode(_w,_h,_options,&error)) {
+    SetErrorMessage(error.c_str());
+  }
+}
+
+void SlideImageWorker::HandleOKCallback() {
+  Nan::HandleScope scope;
+
+  _slide->stats->RecordCall(Operation(),_micros,_result.Size());
+
+  v8::Local<v8::Object> result = Nan::New<v8::Object>();
+  Nan::Set(result,Nan::New("width").ToLocalChecked(),Nan::New<v8::Number>(_w));
+  Nan::Set(result,Nan::New("height").ToLocalChecked(),Nan::New<v8::Number>(_h));
+  Nan::Set(result,Nan::New("data").ToLocalChecked(),_result.ToBuffer());
+
+  v8::Local<v8::Value> argv[] = { Nan::Null(), result };
+  callback->Call(2, argv);
+}
+
+void SlideImageWorker::HandleErrorCallback() {
+  _slide->stats->RecordError(Operation(),_micros);
+  Nan::AsyncWorker::HandleErrorCallback();
+}
@@ -0,0 +1,38 @@
+#ifndef SLIDEIMAGEWORKER_H
+#define SLIDEIMAGEWORKER_H
+
+#include <nan.h>
+#include <memory>
+#include <string>
+#include "encodedresult.h"
+#include "encoder.h"
+#include "slide.h"
+
+// Renders a whole-slide image on the libuv thread pool: either a
+// thumbnail of w x h or the associated image called name. Calls back
+// with raw ARGB or an encoded image, as for ReadRegionWorker.
+class SlideImageWorker : public Nan::AsyncWorker {
+    public:
+        enum Kind {
+            THUMBNAIL,
+            ASSOCIATED_IMAGE
+        };
+        SlideImageWorker(Nan::Callback *callback, std::shared_ptr<Slide> slide, Kind kind,
+                         const std::string &name, int64_t w, int64_t h,
+                         const EncodeOptions &options);
+        void Execute();
+        void HandleOKCallback();
+        void HandleErrorCallback();
+    private:
+        SlideOperation Operation() const;
+        std::shared_ptr<Slide> _slide;
+        uint64_t _micros;
+        Kind _kind;
+        std::string _name;
+        int64_t _w;
+        int64_t _h;
+        EncodeOptions _options;
+        EncodedResult _result;
+};
+
+#endif
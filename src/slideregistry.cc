@@ -0,0 +1,115 @@
+#include "slideregistry.h"
+#include "parallel.h"
+#include <algorithm>
+#include <thread>
+
+SlideRegistry slideRegistry;
+
+SlideRegistry::SlideRegistry() : _openHandles(0), _maxSlides(64), _maxHandles(256) {
+  size_t cores = std::thread::hardware_concurrency();
+  _handlesPerSlide = cores == 0 ? 2 : std::min(cores, (size_t)8);
+}
+
+std::shared_ptr<Slide> SlideRegistry::Open(const std::string &fileName) {
+  size_t handlesPerSlide;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::map<std::string,SlideList::iterator>::iterator it = _index.find(fileName);
+    if (it != _index.end()) {
+      _lru.splice(_lru.begin(),_lru,it->second);
+      (*it->second)->stats->RecordOpen(false,0);
+      return *it->second;
+    }
+    handlesPerSlide = _handlesPerSlide;
+  }
+
+  // Opening can take a long time (MIRAX, NDPI), don't hold the lock
+  uint64_t start = NowMicros();
+  openslide_t *osr = openslide_open(fileName.c_str());
+  if (osr == NULL) {
+    return std::shared_ptr<Slide>();
+  }
+  if (openslide_get_error(osr) != NULL) {
+    openslide_close(osr);
+    return std::shared_ptr<Slide>();
+  }
+  _openHandles++;
+  std::shared_ptr<Slide> slide = std::make_shared<Slide>(fileName,osr,handlesPerSlide,this);
+  uint64_t micros = NowMicros() - start;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::map<std::string,SlideList::iterator>::iterator it = _index.find(fileName);
+  if (it != _index.end()) {
+    // Another caller opened the same file meanwhile, keep theirs
+    _lru.splice(_lru.begin(),_lru,it->second);
+    slide->stats->RecordOpen(true,micros);
+    return *it->second;
+  }
+  slide->stats->RecordOpen(true,micros);
+  _lru.push_front(slide);
+  _index[fileName] = _lru.begin();
+  EvictIdle(_maxSlides,_maxHandles);
+  return slide;
+}
+
+void SlideRegistry::Configure(size_t maxSlides, size_t maxHandles, size_t handlesPerSlide) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _maxSlides = maxSlides;
+  _maxHandles = maxHandles;
+  _handlesPerSlide = handlesPerSlide > 0 ? handlesPerSlide : 1;
+  // No more decodes can run at once than there are handles
+  decodePool.SetMaxThreads(maxHandles);
+  EvictIdle(_maxSlides,_maxHandles);
+}
+
+size_t SlideRegistry::MaxSlides() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _maxSlides;
+}
+
+size_t SlideRegistry::MaxHandles() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _maxHandles;
+}
+
+size_t SlideRegistry::HandlesPerSlide() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _handlesPerSlide;
+}
+
+void SlideRegistry::Clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  EvictIdle(0,0);
+}
+
+bool SlideRegistry::Reserve(bool force) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!force && _openHandles >= _maxHandles) {
+    // Make room for one more
+    EvictIdle(_maxSlides,_maxHandles > 0 ? _maxHandles - 1 : 0);
+    if (_openHandles >= _maxHandles) {
+      return false;
+    }
+  }
+  _openHandles++;
+  return true;
+}
+
+void SlideRegistry::Return() {
+  _openHandles--;
+}
+
+void SlideRegistry::EvictIdle(size_t maxSlides, size_t maxHandles) {
+  // Walk from the least recently used end, skipping slides still in use.
+  // Erasing the last reference closes the slide's handles, which Return
+  // takes off _openHandles.
+  SlideList::iterator it = _lru.end();
+  while (it != _lru.begin() && (_lru.size() > maxSlides || _openHandles > maxHandles)) {
+    --it;
+    if (it->use_count() > 1) {
+      continue;
+    }
+    _index.erase((*it)->fileName);
+    it = _lru.erase(it);
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef SLIDEREGISTRY_H
+#define SLIDEREGISTRY_H
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "slide.h"
+
+// Per-process cache of open slides keyed by path, so repeated opens of
+// the same file skip openslide_open and the metadata scan. A slide is
+// idle when only the registry references it; idle slides are closed in
+// least recently used order once there are more than maxSlides slides
+// or more than maxHandles openslide_t handles open overall. Each handle
+// carries its own openslide tile cache, so the handle budget is what
+// bounds memory. Handle pools charge every handle they open against it:
+// a pool that would go over evicts idle slides first and otherwise waits
+// for its own handles. Only a slide's first handle is never refused, so
+// slides in use can still exceed the budget by one handle each.
+class SlideRegistry : public HandleBudget {
+    public:
+        SlideRegistry();
+        // Returns NULL if the file cannot be opened
+        std::shared_ptr<Slide> Open(const std::string &fileName);
+        // Applies to slides opened from now on, except the limits which
+        // are enforced immediately
+        void Configure(size_t maxSlides, size_t maxHandles, size_t handlesPerSlide);
+        size_t MaxSlides();
+        size_t MaxHandles();
+        size_t HandlesPerSlide();
+        // Closes every idle slide
+        void Clear();
+        // HandleBudget
+        bool Reserve(bool force);
+        void Return();
+    private:
+        typedef std::list<std::shared_ptr<Slide> > SlideList;
+        void EvictIdle(size_t maxSlides, size_t maxHandles);
+        std::mutex _mutex;
+        // Atomic since slides give their handles back from their
+        // destructor, which may run with or without _mutex held
+        std::atomic<size_t> _openHandles;
+        SlideList _lru;
+        std::map<std::string,SlideList::iterator> _index;
+        size_t _maxSlides;
+        size_t _maxHandles;
+        size_t _handlesPerSlide;
+};
+
+extern SlideRegistry slideRegistry;
+
+#endif
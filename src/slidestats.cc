@@ -0,0 +1,140 @@
+#include "slidestats.h"
+#include <chrono>
+
+SlideStatsTable slideStats;
+
+static const char *OPERATION_NAMES[OP_COUNT] = {
+  "readRegion",
+  "readRegions",
+  "deepZoomTile",
+  "thumbnail",
+  "associatedImage"
+};
+
+const char *SlideOperationName(SlideOperation op) {
+  return OPERATION_NAMES[op];
+}
+
+uint64_t NowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Add(std::atomic<uint64_t> &counter, uint64_t value) {
+  counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+static uint64_t Load(const std::atomic<uint64_t> &counter) {
+  return counter.load(std::memory_order_relaxed);
+}
+
+LatencyHistogram::LatencyHistogram() {
+  Reset();
+}
+
+void LatencyHistogram::Record(uint64_t micros) {
+  size_t bucket = 0;
+  while (bucket < LATENCY_BUCKETS - 1 && (micros >> (bucket + 1)) != 0) {
+    bucket++;
+  }
+  Add(_count, 1);
+  Add(_micros, micros);
+  Add(_buckets[bucket], 1);
+}
+
+void LatencyHistogram::Snapshot(LatencySnapshot *snapshot) const {
+  snapshot->count = Load(_count);
+  snapshot->micros = Load(_micros);
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    snapshot->buckets[i] = Load(_buckets[i]);
+  }
+}
+
+void LatencyHistogram::Reset() {
+  _count = 0;
+  _micros = 0;
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    _buckets[i] = 0;
+  }
+}
+
+SlideStats::SlideStats() {
+  Reset();
+}
+
+void SlideStats::RecordOpen(bool cold, uint64_t micros) {
+  Add(_opens, 1);
+  if (cold) {
+    Add(_coldOpens, 1);
+    _coldOpenLatency.Record(micros);
+  }
+}
+
+void SlideStats::RecordCall(SlideOperation op, uint64_t micros, uint64_t bytes) {
+  Add(_operations[op].bytes, bytes);
+  _operations[op].latency.Record(micros);
+}
+
+void SlideStats::RecordError(SlideOperation op, uint64_t micros) {
+  Add(_operations[op].errors, 1);
+  _operations[op].latency.Record(micros);
+}
+
+void SlideStats::RecordDecode(uint64_t micros, uint64_t pixels) {
+  _decodeLatency.Record(micros);
+  Add(_decodedPixels, pixels);
+}
+
+void SlideStats::Snapshot(SlideStatsSnapshot *snapshot) const {
+  snapshot->opens = Load(_opens);
+  snapshot->coldOpens = Load(_coldOpens);
+  _coldOpenLatency.Snapshot(&snapshot->coldOpenLatency);
+  for (size_t i = 0; i < OP_COUNT; i++) {
+    snapshot->operations[i].errors = Load(_operations[i].errors);
+    snapshot->operations[i].bytes = Load(_operations[i].bytes);
+    _operations[i].latency.Snapshot(&snapshot->operations[i].latency);
+  }
+  _decodeLatency.Snapshot(&snapshot->decodeLatency);
+  snapshot->decodedPixels = Load(_decodedPixels);
+}
+
+void SlideStats::Reset() {
+  _opens = 0;
+  _coldOpens = 0;
+  _coldOpenLatency.Reset();
+  for (size_t i = 0; i < OP_COUNT; i++) {
+    _operations[i].errors = 0;
+    _operations[i].bytes = 0;
+    _operations[i].latency.Reset();
+  }
+  _decodeLatency.Reset();
+  _decodedPixels = 0;
+}
+
+std::shared_ptr<SlideStats> SlideStatsTable::ForFile(const std::string &fileName) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::shared_ptr<SlideStats> &stats = _stats[fileName];
+  if (!stats) {
+    stats = std::make_shared<SlideStats>();
+  }
+  return stats;
+}
+
+void SlideStatsTable::Snapshot(std::vector<SlideStatsSnapshot> *snapshots) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  snapshots->resize(_stats.size());
+  size_t i = 0;
+  for (std::map<std::string,std::shared_ptr<SlideStats> >::const_iterator it = _stats.begin();
+       it != _stats.end(); ++it, ++i) {
+    (*snapshots)[i].fileName = it->first;
+    it->second->Snapshot(&(*snapshots)[i]);
+  }
+}
+
+void SlideStatsTable::Reset() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (std::map<std::string,std::shared_ptr<SlideStats> >::iterator it = _stats.begin();
+       it != _stats.end(); ++it) {
+    it->second->Reset();
+  }
+}
@@ -0,0 +1,118 @@
+#ifndef SLIDESTATS_H
+#define SLIDESTATS_H
+
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Calls made through the JS API, counted separately per slide
+enum SlideOperation {
+  OP_READ_REGION,       // readRegion, readRegionAsync, readRegionInto
+  OP_READ_REGIONS,      // one per readRegions batch
+  OP_DEEPZOOM_TILE,
+  OP_THUMBNAIL,
+  OP_ASSOCIATED_IMAGE,
+  OP_COUNT
+};
+
+const char *SlideOperationName(SlideOperation op);
+
+// Bucket i counts durations of [2^i, 2^(i+1)) microseconds, except the
+// first which also takes 0 and the last which takes everything longer
+static const size_t LATENCY_BUCKETS = 24;
+
+uint64_t NowMicros();
+
+// Sets *micros to the time between construction and destruction
+class OperationTimer {
+    public:
+        explicit OperationTimer(uint64_t *micros) : _micros(micros), _start(NowMicros()) {}
+        ~OperationTimer() { *_micros = NowMicros() - _start; }
+    private:
+        uint64_t *_micros;
+        uint64_t _start;
+};
+
+struct LatencySnapshot {
+  uint64_t count;
+  uint64_t micros;
+  uint64_t buckets[LATENCY_BUCKETS];
+};
+
+struct OperationSnapshot {
+  uint64_t errors;
+  uint64_t bytes;
+  LatencySnapshot latency;
+};
+
+struct SlideStatsSnapshot {
+  std::string fileName;
+  // Registry lookups; cold ones actually ran openslide_open
+  uint64_t opens;
+  uint64_t coldOpens;
+  LatencySnapshot coldOpenLatency;
+  OperationSnapshot operations[OP_COUNT];
+  // Individual openslide_read_region and openslide_read_associated_image
+  // calls, whichever operation or cache miss caused them
+  LatencySnapshot decodeLatency;
+  uint64_t decodedPixels;
+};
+
+class LatencyHistogram {
+    public:
+        LatencyHistogram();
+        void Record(uint64_t micros);
+        void Snapshot(LatencySnapshot *snapshot) const;
+        void Reset();
+    private:
+        std::atomic<uint64_t> _count;
+        std::atomic<uint64_t> _micros;
+        std::atomic<uint64_t> _buckets[LATENCY_BUCKETS];
+};
+
+// Counters for one slide file. Recording only touches relaxed atomics,
+// so reader threads never wait on each other to update them.
+class SlideStats {
+    public:
+        SlideStats();
+        void RecordOpen(bool cold, uint64_t micros);
+        void RecordCall(SlideOperation op, uint64_t micros, uint64_t bytes);
+        void RecordError(SlideOperation op, uint64_t micros);
+        void RecordDecode(uint64_t micros, uint64_t pixels);
+        void Snapshot(SlideStatsSnapshot *snapshot) const;
+        void Reset();
+    private:
+        struct Operation {
+          std::atomic<uint64_t> errors;
+          std::atomic<uint64_t> bytes;
+          LatencyHistogram latency;
+        };
+        std::atomic<uint64_t> _opens;
+        std::atomic<uint64_t> _coldOpens;
+        LatencyHistogram _coldOpenLatency;
+        Operation _operations[OP_COUNT];
+        LatencyHistogram _decodeLatency;
+        std::atomic<uint64_t> _decodedPixels;
+};
+
+// Stats of every slide file opened so far, by path. They outlive the
+// Slide itself, so a slide evicted from the registry and opened again
+// keeps adding to the same counters.
+class SlideStatsTable {
+    public:
+        std::shared_ptr<SlideStats> ForFile(const std::string &fileName);
+        void Snapshot(std::vector<SlideStatsSnapshot> *snapshots);
+        // Zeroes every counter, slides keep their entries
+        void Reset();
+    private:
+        std::mutex _mutex;
+        std::map<std::string,std::shared_ptr<SlideStats> > _stats;
+};
+
+extern SlideStatsTable slideStats;
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// Assertions for the native tests. Failures are reported and counted,
+// and TestResult turns the count into the exit status.
+static int checkFailures = 0;
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+      checkFailures++; \
+    } \
+  } while (0)
+
+static inline int TestResult(const char *name) {
+  if (checkFailures != 0) {
+    fprintf(stderr, "%s: %d checks failed\n", name, checkFailures);
+    return 1;
+  }
+  printf("%s: ok\n", name);
+  return 0;
+}
+
+#endif
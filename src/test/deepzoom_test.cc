@@ -0,0 +1,114 @@
+#include "check.h"
+#include "deepzoom.h"
+#include "regionreader.h"
+#include "resample.h"
+#include "slideregistry.h"
+#include "standin/standin.h"
+#include "testslide.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+static const int64_t WIDTH = 3000;
+static const int64_t HEIGHT = 2000;
+
+// Tile (0, 0) of a Deep Zoom level, rendered by reading the whole source
+// region at once and scaling it in one go
+static bool ReadTileWhole(Slide *slide, int64_t downsample, int64_t zW, int64_t zH,
+                          uint32_t *dest) {
+  int64_t lW = std::min(downsample * zW, WIDTH);
+  int64_t lH = std::min(downsample * zH, HEIGHT);
+  std::vector<uint32_t> region(lW * lH);
+  std::string error;
+  if (!ReadRegionTiled(slide, &region[0], 0, 0, 0, lW, lH, &error)) {
+    return false;
+  }
+  ResampleArea(&region[0], lW, lH, dest, zW, zH);
+  return true;
+}
+
+static void RemovePyramid(const std::string &basename, const DeepZoom &deepZoom) {
+  std::string directory = basename + "_files";
+  for (int level = 0; level < deepZoom.LevelCount(); level++) {
+    std::ostringstream levelDirectory;
+    levelDirectory << directory << "/" << level;
+    for (int64_t row = 0; row < deepZoom.LevelRows(level); row++) {
+      for (int64_t col = 0; col < deepZoom.LevelColumns(level); col++) {
+        std::ostringstream path;
+        path << levelDirectory.str() << "/" << col << "_" << row << ".jpeg";
+        CHECK(remove(path.str().c_str()) == 0);
+      }
+    }
+    rmdir(levelDirectory.str().c_str());
+  }
+  rmdir(directory.c_str());
+  remove((basename + ".dzi").c_str());
+}
+
+int main() {
+  // A single level, so every Deep Zoom level but the last is scaled down
+  // from level 0, across several bands for the smaller ones
+  std::string path = TestSlidePath("deepzoom");
+  CHECK(WriteTestSlide(path, WIDTH, HEIGHT, 256, 1));
+  std::shared_ptr<Slide> slide = slideRegistry.Open(path);
+  CHECK(slide && slide->levelCount == 1);
+  std::unique_ptr<DeepZoom> zoom(new DeepZoom(slide, 254, 1, false));
+  const DeepZoom &deepZoom = *zoom;
+  int last = deepZoom.LevelCount() - 1;
+  CHECK(deepZoom.LevelWidth(last) == WIDTH && deepZoom.LevelHeight(last) == HEIGHT);
+
+  for (int level = last - 1; level >= last - 5; level--) {
+    int64_t downsample = (int64_t)1 << (last - level);
+    int64_t w = 0, h = 0;
+    CHECK(deepZoom.GetTileSize(level, 0, 0, &w, &h));
+    std::vector<uint32_t> banded(w * h), whole(w * h);
+    std::string error;
+    CHECK(deepZoom.ReadTile(level, 0, 0, &banded[0], &error));
+    CHECK(ReadTileWhole(slide.get(), downsample, w, h, &whole[0]));
+    CHECK(banded == whole);
+  }
+
+  // Bands shrink to the region limit, but the source rows under one
+  // tile row must fit in it
+  {
+    size_t limit = GetMaxRegionBytes();
+    SetMaxRegionBytes(WIDTH * 4 * 8);
+    int64_t w = 0, h = 0;
+    CHECK(deepZoom.GetTileSize(last - 4, 0, 0, &w, &h));
+    std::vector<uint32_t> pixels(w * h);
+    std::string error;
+    CHECK(!deepZoom.ReadTile(last - 4, 0, 0, &pixels[0], &error));
+    CHECK(!error.empty());
+    CHECK(deepZoom.GetTileSize(last - 2, 0, 0, &w, &h));
+    std::vector<uint32_t> banded(w * h), whole(w * h);
+    CHECK(deepZoom.ReadTile(last - 2, 0, 0, &banded[0], &error));
+    SetMaxRegionBytes(limit);
+    CHECK(ReadTileWhole(slide.get(), 4, w, h, &whole[0]));
+    CHECK(banded == whole);
+  }
+
+  // An absurd thread count is capped rather than honoured
+  {
+    std::string smallPath = TestSlidePath("deepzoom-small");
+    CHECK(WriteTestSlide(smallPath, 600, 400, 256));
+    DeepZoom smallZoom(slideRegistry.Open(smallPath), 254, 1, false);
+    EncodeOptions options;
+    DefaultEncodeOptions(&options);
+    options.format = FORMAT_JPEG;
+    std::string basename = TestSlidePath("deepzoom-export");
+    std::string error;
+    CHECK(smallZoom.ExportPyramid(basename, options, 1000000, &error));
+    RemovePyramid(basename, smallZoom);
+    remove(smallPath.c_str());
+  }
+
+  zoom.reset();
+  slide.reset();
+  slideRegistry.Clear();
+  CHECK(StandinOpenHandles() == 0);
+  remove(path.c_str());
+  return TestResult("deepzoom_test");
+}
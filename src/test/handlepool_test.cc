@@ -0,0 +1,146 @@
+#include "check.h"
+#include "regionreader.h"
+#include "slideregistry.h"
+#include "standin/standin.h"
+#include "testslide.h"
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static const int64_t WIDTH = 2048;
+static const int64_t HEIGHT = 1536;
+
+// Grants nothing beyond a pool's first handle
+struct RefusingBudget : HandleBudget {
+  bool Reserve(bool force) { return force; }
+  void Return() {}
+};
+
+struct Reader {
+  Slide *slide;
+  std::vector<uint32_t> *pixels;
+  bool *ok;
+  void operator()() {
+    std::string error;
+    *ok = ReadRegionTiled(slide, &(*pixels)[0], 0, 0, 0, WIDTH, HEIGHT, &error);
+  }
+};
+
+static bool MatchesSlide(const std::vector<uint32_t> &pixels, int32_t level,
+                         int64_t x, int64_t y, int64_t w, int64_t h) {
+  for (int64_t row = 0; row < h; row++) {
+    for (int64_t col = 0; col < w; col++) {
+      if (pixels[row * w + col] != TestSlidePixel(level, x + col, y + row)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+struct Holder {
+  HandlePool *pool;
+  void operator()() {
+    openslide_t *osr = pool->Acquire();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    pool->Release(osr);
+  }
+};
+
+int main() {
+  std::string paths[3];
+  for (int i = 0; i < 3; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "pool%d", i);
+    paths[i] = TestSlidePath(name);
+    CHECK(WriteTestSlide(paths[i], WIDTH, HEIGHT, 256));
+  }
+
+  // Region size checks are exact at the limit and cannot overflow
+  {
+    size_t limit = GetMaxRegionBytes();
+    SetMaxRegionBytes(1000 * 4);
+    CHECK(RegionFitsLimit(1000, 1) && RegionFitsLimit(10, 100));
+    CHECK(!RegionFitsLimit(1001, 1) && !RegionFitsLimit(0, 1) && !RegionFitsLimit(5, -1));
+    SetMaxRegionBytes(limit);
+    CHECK(!RegionFitsLimit((int64_t)1 << 32, (int64_t)1 << 32));
+    CHECK(!RegionFitsLimit(INT64_MAX, INT64_MAX));
+  }
+
+  // Strips land in the right rows, on every level
+  {
+    std::shared_ptr<Slide> slide = slideRegistry.Open(paths[0]);
+    CHECK(slide && slide->levelCount == 4);
+    CHECK(slide->levelWidths[1] == WIDTH / 2 && slide->levelDownsamples[1] == 2.0);
+    std::vector<uint32_t> pixels(1000 * 700);
+    std::string error;
+    CHECK(ReadRegionTiled(slide.get(), &pixels[0], 300, 200, 0, 1000, 700, &error));
+    CHECK(MatchesSlide(pixels, 0, 300, 200, 1000, 700));
+    CHECK(ReadRegionTiled(slide.get(), &pixels[0], 300, 200, 1, 600, 500, &error));
+    CHECK(MatchesSlide(pixels, 1, 150, 100, 600, 500));
+  }
+  slideRegistry.Clear();
+  CHECK(StandinOpenHandles() == 0);
+
+  // Parallel reads of two slides stay within the handle budget, and the
+  // idle third slide is closed to make room
+  {
+    slideRegistry.Configure(64, 4, 8);
+    std::shared_ptr<Slide> a = slideRegistry.Open(paths[0]);
+    std::shared_ptr<Slide> b = slideRegistry.Open(paths[1]);
+    slideRegistry.Open(paths[2]);
+    CHECK(StandinOpenHandles() == 3);
+    StandinResetPeakHandles();
+
+    std::vector<uint32_t> pixelsA(WIDTH * HEIGHT), pixelsB(WIDTH * HEIGHT);
+    bool okA = false, okB = false;
+    Reader readB = { b.get(), &pixelsB, &okB };
+    std::thread thread(readB);
+    Reader readA = { a.get(), &pixelsA, &okA };
+    readA();
+    thread.join();
+    CHECK(okA && okB);
+    CHECK(StandinPeakHandles() <= 4);
+    CHECK(MatchesSlide(pixelsA, 0, 0, 0, WIDTH, HEIGHT));
+    CHECK(MatchesSlide(pixelsB, 0, 0, 0, WIDTH, HEIGHT));
+    CHECK(a->handles.OpenHandles() + b->handles.OpenHandles() <= 4);
+  }
+  slideRegistry.Clear();
+  CHECK(StandinOpenHandles() == 0);
+
+  // A pool refused by its budget waits for its one handle
+  {
+    RefusingBudget budget;
+    HandlePool pool(paths[0], openslide_open(paths[0].c_str()), 4, &budget);
+    Holder holder = { &pool };
+    std::thread thread(holder);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    openslide_t *osr = pool.Acquire();
+    CHECK(osr != NULL);
+    pool.Release(osr);
+    thread.join();
+    CHECK(pool.OpenHandles() == 1);
+  }
+
+  // Without a budget a pool grows to maxHandles and no further
+  {
+    HandlePool pool(paths[0], openslide_open(paths[0].c_str()), 3);
+    openslide_t *handles[3];
+    for (int i = 0; i < 3; i++) {
+      handles[i] = pool.Acquire();
+      CHECK(handles[i] != NULL);
+    }
+    CHECK(handles[0] != handles[1] && handles[1] != handles[2]);
+    CHECK(pool.OpenHandles() == 3);
+    for (int i = 0; i < 3; i++) {
+      pool.Release(handles[i]);
+    }
+  }
+  CHECK(StandinOpenHandles() == 0);
+
+  for (int i = 0; i < 3; i++) {
+    remove(paths[i].c_str());
+  }
+  return TestResult("handlepool_test");
+}
@@ -0,0 +1,98 @@
+#include "check.h"
+#include "parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+// Records each index and which thread ran it
+struct Mark {
+  std::vector<int> *hits;
+  std::set<std::thread::id> *threads;
+  std::mutex *mutex;
+  void operator()(size_t i) {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    std::lock_guard<std::mutex> lock(*mutex);
+    (*hits)[i]++;
+    threads->insert(std::this_thread::get_id());
+  }
+};
+
+// Runs a parallel loop of its own from inside one
+struct Nested {
+  std::atomic<int> *total;
+  struct Inner {
+    std::atomic<int> *total;
+    void operator()(size_t) { (*total)++; }
+  };
+  void operator()(size_t) {
+    Inner inner = { total };
+    ParallelFor(16, 8, inner);
+  }
+};
+
+// Starts a nested loop from a thread of its own
+struct Caller {
+  Nested *nested;
+  void operator()() { ParallelFor(8, 4, *nested); }
+};
+
+int main() {
+  // Every index runs once, on no more threads than asked for
+  {
+    std::vector<int> hits(100);
+    std::set<std::thread::id> threads;
+    std::mutex mutex;
+    Mark mark = { &hits, &threads, &mutex };
+    ParallelFor(hits.size(), 4, mark);
+    CHECK(hits == std::vector<int>(100, 1));
+    CHECK(threads.size() <= 4);
+    CHECK(threads.count(std::this_thread::get_id()) == 1);
+  }
+
+  // Threads are kept between calls and never exceed the limit
+  {
+    decodePool.SetMaxThreads(3);
+    size_t before = decodePool.Threads();
+    std::set<std::thread::id> threads;
+    std::mutex mutex;
+    for (int call = 0; call < 50; call++) {
+      std::vector<int> hits(16);
+      Mark mark = { &hits, &threads, &mutex };
+      ParallelFor(hits.size(), 8, mark);
+      CHECK(hits == std::vector<int>(16, 1));
+    }
+    CHECK(decodePool.Threads() <= std::max(before, (size_t)3));
+    CHECK(threads.size() <= std::max(before, (size_t)3) + 1);
+    decodePool.SetMaxThreads(256);
+  }
+
+  // Nested loops finish even when every pool thread is busy
+  {
+    decodePool.SetMaxThreads(2);
+    std::atomic<int> total(0);
+    Nested nested = { &total };
+    ParallelFor(32, 8, nested);
+    CHECK(total == 32 * 16);
+    decodePool.SetMaxThreads(256);
+  }
+
+  // Loops started from several threads at once share the pool
+  {
+    std::atomic<int> total(0);
+    Nested nested = { &total };
+    Caller caller = { &nested };
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 4; i++) {
+      callers.push_back(std::thread(caller));
+    }
+    for (size_t i = 0; i < callers.size(); i++) {
+      callers[i].join();
+    }
+    CHECK(total == 4 * 8 * 16);
+  }
+
+  return TestResult("parallel_test");
+}
@@ -0,0 +1,56 @@
+#include "check.h"
+#include "pixelconvert.h"
+#include <stdlib.h>
+#include <vector>
+
+// The same source built without the SSSE3 kernels, to compare against
+#define PIXELCONVERT_SCALAR_ONLY
+namespace scalar {
+#include "../pixelconvert.cc"
+}
+
+// Mostly opaque runs broken by translucent pixels, like tissue edges
+static std::vector<uint32_t> SlidePixels(size_t count) {
+  std::vector<uint32_t> pixels(count);
+  for (size_t i = 0; i < count; i++) {
+    uint32_t a = rand() % 8 == 0 ? rand() % 256 : 255;
+    uint32_t r = rand() % (a + 1), g = rand() % (a + 1), b = rand() % (a + 1);
+    pixels[i] = (a << 24) | (r << 16) | (g << 8) | b;
+  }
+  return pixels;
+}
+
+int main() {
+  srand(1);
+#if defined(__x86_64__) || defined(__i386__)
+  if (!__builtin_cpu_supports("ssse3")) {
+    printf("pixelconvert_test: no SSSE3 on this CPU, both paths are scalar\n");
+  }
+#endif
+  // Odd lengths and offsets exercise the tails and unaligned loads
+  for (size_t count = 0; count < 300; count++) {
+    for (size_t offset = 0; offset < 4; offset++) {
+      std::vector<uint32_t> src = SlidePixels(count + offset);
+      std::vector<uint8_t> rgba(count * 4), scalarRgba(count * 4);
+      std::vector<uint8_t> rgb(count * 3), scalarRgb(count * 3);
+      ArgbToRgba(&src[offset], rgba.data(), count);
+      scalar::ArgbToRgba(&src[offset], scalarRgba.data(), count);
+      ArgbToRgb(&src[offset], rgb.data(), count, 0xfff0e0);
+      scalar::ArgbToRgb(&src[offset], scalarRgb.data(), count, 0xfff0e0);
+      CHECK(rgba == scalarRgba);
+      CHECK(rgb == scalarRgb);
+    }
+  }
+
+  // Known values: opaque, half-transparent and fully transparent
+  uint32_t pixels[] = { 0xff102030, 0x80402010, 0x00000000 };
+  uint8_t rgba[12], rgb[9];
+  ArgbToRgba(pixels, rgba, 3);
+  ArgbToRgb(pixels, rgb, 3, 0xffffff);
+  CHECK(rgba[0] == 0x10 && rgba[1] == 0x20 && rgba[2] == 0x30 && rgba[3] == 0xff);
+  CHECK(rgba[4] == 0x80 && rgba[5] == 0x40 && rgba[6] == 0x20 && rgba[7] == 0x80);
+  CHECK(rgba[11] == 0);
+  CHECK(rgb[3] == 0x40 + 0x7f && rgb[4] == 0x20 + 0x7f && rgb[5] == 0x10 + 0x7f);
+  CHECK(rgb[6] == 0xff && rgb[7] == 0xff && rgb[8] == 0xff);
+  return TestResult("pixelconvert_test");
+}
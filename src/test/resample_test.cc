@@ -0,0 +1,69 @@
+#include "check.h"
+#include "resample.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+static std::vector<uint32_t> RandomPixels(int64_t count) {
+  std::vector<uint32_t> pixels(count);
+  for (int64_t i = 0; i < count; i++) {
+    // Valid premultiplied ARGB: no channel above alpha
+    uint32_t a = rand() % 4 == 0 ? rand() % 256 : 255;
+    uint32_t r = rand() % (a + 1), g = rand() % (a + 1), b = rand() % (a + 1);
+    pixels[i] = (a << 24) | (r << 16) | (g << 8) | b;
+  }
+  return pixels;
+}
+
+// Banded output must match scaling the whole source at once
+static void CheckBands(int64_t sw, int64_t sh, int64_t dw, int64_t dh, int64_t bandRows) {
+  std::vector<uint32_t> src = RandomPixels(sw * sh);
+  std::vector<uint32_t> whole(dw * dh), banded(dw * dh);
+  ResampleArea(&src[0], sw, sh, &whole[0], dw, dh);
+
+  AreaResampler resampler(sw, sh, dw, dh);
+  for (int64_t y0 = 0; y0 < dh; y0 += bandRows) {
+    int64_t y1 = std::min(y0 + bandRows, dh);
+    int64_t first, last;
+    resampler.SourceRows(y0, y1, &first, &last);
+    CHECK(first >= 0 && first < last && last <= sh);
+    // Only the band's own rows, as ReadThumbnail reads them
+    std::vector<uint32_t> rows(src.begin() + first * sw, src.begin() + last * sw);
+    resampler.Resample(&rows[0], y0, y1, &banded[y0 * dw]);
+  }
+  CHECK(banded == whole);
+}
+
+static void CheckUniform(int64_t sw, int64_t sh, int64_t dw, int64_t dh) {
+  std::vector<uint32_t> src(sw * sh, 0xff336699);
+  std::vector<uint32_t> dst(dw * dh);
+  ResampleArea(&src[0], sw, sh, &dst[0], dw, dh);
+  CHECK(std::count(dst.begin(), dst.end(), 0xff336699u) == dw * dh);
+}
+
+int main() {
+  srand(1);
+  const int64_t sizes[][4] = {
+    { 512, 384, 256, 192 },   // exact halving
+    { 1000, 700, 333, 233 },
+    { 641, 479, 100, 75 },
+    { 300, 2000, 17, 113 },
+    { 257, 255, 256, 254 },
+    { 50, 40, 1, 1 }
+  };
+  const int64_t bands[] = { 1, 7, 64, 1 << 20 };
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    for (size_t b = 0; b < sizeof(bands) / sizeof(bands[0]); b++) {
+      CheckBands(sizes[i][0], sizes[i][1], sizes[i][2], sizes[i][3], bands[b]);
+    }
+    CheckUniform(sizes[i][0], sizes[i][1], sizes[i][2], sizes[i][3]);
+  }
+
+  // 2:1 averages each 2x2 block
+  uint32_t block[] = { 0xff000000, 0xff040404, 0xff080808, 0xff0c0c0c };
+  uint32_t halved = 0;
+  uint32_t src[] = { block[0], block[1], block[2], block[3] };
+  ResampleArea(src, 2, 2, &halved, 1, 1);
+  CHECK(halved == 0xff060606);
+  return TestResult("resample_test");
+}
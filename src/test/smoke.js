@@ -0,0 +1,177 @@
+// Exercises the JS bindings end to end against a small synthetic slide
+// from bench/tiff.js. Run with `npm test`, after building the addon.
+var assert = require('assert');
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var addon = require('bindings')('openslide');
+var tiff = require('../bench/tiff');
+
+var WIDTH = 1500, HEIGHT = 1100, TILE_SIZE = 256;
+
+var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'openslide-smoke-'));
+var file = path.join(dir, 'slide.tiff');
+tiff.writeSyntheticSlide(file, WIDTH, HEIGHT, TILE_SIZE);
+var levels = tiff.levelSizes(WIDTH, HEIGHT, TILE_SIZE);
+
+function removeTree(target) {
+  if (fs.statSync(target).isDirectory()) {
+    fs.readdirSync(target).forEach(function(name) {
+      removeTree(path.join(target, name));
+    });
+    fs.rmdirSync(target);
+  } else {
+    fs.unlinkSync(target);
+  }
+}
+
+function countFiles(target) {
+  if (!fs.statSync(target).isDirectory()) {
+    return 1;
+  }
+  return fs.readdirSync(target).reduce(function(count, name) {
+    return count + countFiles(path.join(target, name));
+  }, 0);
+}
+
+var slide = new addon.OpenSlideObject(file);
+assert.ok(slide.open());
+assert.strictEqual(slide.levelCount, levels.length);
+levels.forEach(function(level, l) {
+  assert.strictEqual(slide.levelWidths[l], level.width);
+  assert.strictEqual(slide.levelHeights[l], level.height);
+});
+assert.strictEqual(slide.getPropertyValue('openslide.vendor'), 'generic-tiff');
+
+var steps = [
+  function rawCache(next) {
+    // Raw regions are only cached on request; the steps after this one
+    // run with it on
+    var before = addon.getTileCacheStats();
+    var first = slide.readRegion(0, 512, 512, 128, 128);
+    assert.ok(slide.readRegion(0, 512, 512, 128, 128).equals(first));
+    var after = addon.getTileCacheStats();
+    assert.strictEqual(after.insertions, before.insertions);
+    assert.strictEqual(after.hits, before.hits);
+    addon.configureTileCache({cacheRaw: true});
+    slide.readRegion(0, 512, 512, 128, 128);
+    assert.ok(slide.readRegion(0, 512, 512, 128, 128).equals(first));
+    after = addon.getTileCacheStats();
+    assert.strictEqual(after.insertions, before.insertions + 1);
+    assert.strictEqual(after.hits, before.hits + 1);
+    next();
+  },
+  function readRegionAsync(next) {
+    var sync = slide.readRegion(1, 300, 200, 400, 300);
+    assert.strictEqual(sync.length, 400 * 300 * 4);
+    slide.readRegionAsync(1, 300, 200, 400, 300, function(err, tile) {
+      assert.ifError(err);
+      assert.ok(tile.equals(sync));
+      next();
+    });
+  },
+  function readRegionInto(next) {
+    var expected = slide.readRegion(0, 100, 50, 64, 32);
+    var buffer = Buffer.alloc(64 * 32 * 4 + 16, 0xaa);
+    slide.readRegionInto(buffer, 8, 0, 100, 50, 64, 32);
+    assert.ok(buffer.slice(8, 8 + expected.length).equals(expected));
+    assert.strictEqual(buffer[0], 0xaa);
+    assert.strictEqual(buffer[buffer.length - 1], 0xaa);
+    buffer.fill(0);
+    slide.readRegionInto(buffer, 8, 0, 100, 50, 64, 32, function(err, result) {
+      assert.ifError(err);
+      assert.strictEqual(result, buffer);
+      assert.ok(buffer.slice(8, 8 + expected.length).equals(expected));
+      // Caller-owned Buffers never fill the cache
+      var insertions = addon.getTileCacheStats().insertions;
+      slide.readRegionInto(buffer, 8, 0, 900, 700, 64, 32, function(err) {
+        assert.ifError(err);
+        assert.strictEqual(addon.getTileCacheStats().insertions, insertions);
+        next();
+      });
+    });
+  },
+  function readRegions(next) {
+    var requests = [
+      {level: 0, x: 0, y: 0, w: 256, h: 256},
+      {level: 1, x: 512, y: 512, w: 128, h: 64},
+      {level: 0, x: 0, y: 0, w: 256, h: 256}
+    ];
+    slide.readRegions(requests, function(err, tiles) {
+      assert.ifError(err);
+      assert.strictEqual(tiles.length, 3);
+      requests.forEach(function(r, i) {
+        assert.ok(tiles[i].equals(slide.readRegion(r.level, r.x, r.y, r.w, r.h)));
+      });
+      next();
+    });
+  },
+  function encoded(next) {
+    slide.readRegionAsync(0, 0, 0, 256, 256, {format: 'jpeg', quality: 80}, function(err, jpeg) {
+      assert.ifError(err);
+      assert.strictEqual(jpeg.readUInt16BE(0), 0xffd8);
+      slide.readRegions([{level: 0, x: 0, y: 0, w: 64, h: 64}], {format: 'png'}, function(err, pngs) {
+        assert.ifError(err);
+        assert.strictEqual(pngs[0].toString('latin1', 1, 4), 'PNG');
+        next();
+      });
+    });
+  },
+  function thumbnail(next) {
+    slide.getThumbnail(200, 200, function(err, image) {
+      assert.ifError(err);
+      assert.strictEqual(image.width, 200);
+      assert.strictEqual(image.height, Math.round(200 * HEIGHT / WIDTH));
+      assert.strictEqual(image.data.length, image.width * image.height * 4);
+      assert.deepStrictEqual(slide.associatedImageNames, []);
+      next();
+    });
+  },
+  function deepZoom(next) {
+    var dz = new addon.DeepZoomGenerator(slide, {tileSize: 254, overlap: 1});
+    var last = dz.levelCount - 1;
+    assert.deepStrictEqual(dz.levelDimensions[last], [WIDTH, HEIGHT]);
+    assert.ok(/<Image /.test(dz.getDzi('jpeg')));
+    dz.getTile(last, 1, 1, function(err, tile) {
+      assert.ifError(err);
+      assert.ok(tile.equals(slide.readRegion(0, 253, 253, 256, 256)));
+      var out = path.join(dir, 'pyramid');
+      dz.exportPyramid(out, {format: 'jpeg', threads: 4}, function(err) {
+        assert.ifError(err);
+        assert.ok(fs.existsSync(out + '.dzi'));
+        assert.strictEqual(countFiles(out + '_files'), dz.tileCount);
+        next();
+      });
+    });
+  },
+  function limits(next) {
+    assert.throws(function() {
+      slide.readRegion(0, 0, 0, 1 << 20, 1 << 20);
+    }, RangeError);
+    next();
+  },
+  function stats(next) {
+    var cache = addon.getTileCacheStats();
+    assert.ok(cache.hits > 0 && cache.entries > 0 && cache.bytes <= cache.maxBytes);
+    var stats = addon.getStats().slides.filter(function(s) {
+      return s.fileName === file;
+    })[0];
+    assert.ok(stats.opens >= 1);
+    assert.ok(stats.operations.readRegion.calls > 0);
+    assert.ok(stats.operations.deepZoomTile.calls > 0);
+    assert.ok(stats.decode.calls > 0);
+    next();
+  }
+];
+
+(function run(i) {
+  if (i === steps.length) {
+    addon.clearSlideCache();
+    removeTree(dir);
+    console.log('smoke: ok');
+    return;
+  }
+  steps[i](function() {
+    run(i + 1);
+  });
+})(0);
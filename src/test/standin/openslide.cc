@@ -0,0 +1,410 @@
+#include <openslide/openslide.h>
+#include "standin.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const uint16_t TAG_IMAGE_WIDTH = 256;
+static const uint16_t TAG_IMAGE_LENGTH = 257;
+static const uint16_t TAG_BITS_PER_SAMPLE = 258;
+static const uint16_t TAG_COMPRESSION = 259;
+static const uint16_t TAG_SAMPLES_PER_PIXEL = 277;
+static const uint16_t TAG_PLANAR_CONFIG = 284;
+static const uint16_t TAG_TILE_WIDTH = 322;
+static const uint16_t TAG_TILE_LENGTH = 323;
+static const uint16_t TAG_TILE_OFFSETS = 324;
+static const uint16_t TAG_TILE_BYTE_COUNTS = 325;
+
+static const uint16_t TYPE_SHORT = 3;
+static const uint16_t TYPE_LONG = 4;
+
+static const uint16_t COMPRESSION_NONE = 1;
+static const uint16_t COMPRESSION_DEFLATE = 8;
+static const uint16_t COMPRESSION_ADOBE_DEFLATE = 32946;
+
+static std::atomic<int64_t> openHandles(0);
+static std::atomic<int64_t> peakHandles(0);
+
+int64_t StandinOpenHandles() {
+  return openHandles;
+}
+
+int64_t StandinPeakHandles() {
+  return peakHandles;
+}
+
+void StandinResetPeakHandles() {
+  peakHandles = (int64_t)openHandles;
+}
+
+struct Level {
+  int64_t width;
+  int64_t height;
+  int64_t tileWidth;
+  int64_t tileHeight;
+  uint16_t compression;
+  std::vector<uint64_t> offsets;
+  std::vector<uint64_t> byteCounts;
+  double downsample;
+};
+
+struct _openslide {
+  int fd;
+  std::vector<Level> levels;
+  std::map<std::string,std::string> properties;
+  std::vector<const char *> propertyNames;
+  std::string error;
+  bool failed;
+};
+
+static bool ReadAt(int fd, uint64_t offset, void *data, size_t size) {
+  char *out = (char *)data;
+  while (size > 0) {
+    ssize_t n = pread(fd, out, size, (off_t)offset);
+    if (n <= 0) {
+      return false;
+    }
+    out += n;
+    offset += n;
+    size -= n;
+  }
+  return true;
+}
+
+// Classic little-endian TIFF only
+static uint16_t U16(const unsigned char *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t U32(const unsigned char *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+// Values of one IFD entry, read from the entry itself or from the file
+static bool EntryValues(int fd, const unsigned char *entry, std::vector<uint64_t> *values) {
+  uint16_t type = U16(entry + 2);
+  uint32_t count = U32(entry + 4);
+  size_t itemSize = type == TYPE_SHORT ? 2 : type == TYPE_LONG ? 4 : 0;
+  if (itemSize == 0) {
+    return false;
+  }
+  std::vector<unsigned char> data(count * itemSize);
+  if (data.size() <= 4) {
+    memcpy(&data[0], entry + 8, data.size());
+  } else if (!ReadAt(fd, U32(entry + 8), &data[0], data.size())) {
+    return false;
+  }
+  values->resize(count);
+  for (uint32_t i = 0; i < count; i++) {
+    (*values)[i] = itemSize == 2 ? U16(&data[i * 2]) : U32(&data[i * 4]);
+  }
+  return true;
+}
+
+// Reads the IFD at offset into level, false if it is not a tiled 8-bit
+// RGB image. Sets *next to the following IFD.
+static bool ReadLevel(int fd, uint64_t offset, Level *level, uint64_t *next, bool *usable) {
+  unsigned char countData[2];
+  if (!ReadAt(fd, offset, countData, 2)) {
+    return false;
+  }
+  uint16_t count = U16(countData);
+  std::vector<unsigned char> entries(count * 12 + 4);
+  if (!ReadAt(fd, offset + 2, &entries[0], entries.size())) {
+    return false;
+  }
+  *next = U32(&entries[count * 12]);
+
+  std::map<uint16_t,std::vector<uint64_t> > tags;
+  for (uint16_t i = 0; i < count; i++) {
+    const unsigned char *entry = &entries[i * 12];
+    std::vector<uint64_t> values;
+    if (EntryValues(fd, entry, &values)) {
+      tags[U16(entry)] = values;
+    }
+  }
+
+  const uint16_t required[] = { TAG_IMAGE_WIDTH, TAG_IMAGE_LENGTH, TAG_TILE_WIDTH,
+                                TAG_TILE_LENGTH, TAG_TILE_OFFSETS, TAG_TILE_BYTE_COUNTS };
+  *usable = false;
+  for (size_t i = 0; i < sizeof(required) / sizeof(required[0]); i++) {
+    if (tags[required[i]].empty()) {
+      return true;
+    }
+  }
+  std::vector<uint64_t> &bits = tags[TAG_BITS_PER_SAMPLE];
+  std::vector<uint64_t> &samples = tags[TAG_SAMPLES_PER_PIXEL];
+  std::vector<uint64_t> &planar = tags[TAG_PLANAR_CONFIG];
+  std::vector<uint64_t> &compression = tags[TAG_COMPRESSION];
+  if ((!bits.empty() && bits[0] != 8) || samples.empty() || samples[0] != 3 ||
+      (!planar.empty() && planar[0] != 1)) {
+    return true;
+  }
+  level->compression = compression.empty() ? COMPRESSION_NONE : (uint16_t)compression[0];
+  if (level->compression != COMPRESSION_NONE && level->compression != COMPRESSION_DEFLATE &&
+      level->compression != COMPRESSION_ADOBE_DEFLATE) {
+    return true;
+  }
+  level->width = tags[TAG_IMAGE_WIDTH][0];
+  level->height = tags[TAG_IMAGE_LENGTH][0];
+  level->tileWidth = tags[TAG_TILE_WIDTH][0];
+  level->tileHeight = tags[TAG_TILE_LENGTH][0];
+  level->offsets = tags[TAG_TILE_OFFSETS];
+  level->byteCounts = tags[TAG_TILE_BYTE_COUNTS];
+  int64_t tiles = ((level->width + level->tileWidth - 1) / level->tileWidth) *
+                  ((level->height + level->tileHeight - 1) / level->tileHeight);
+  *usable = level->tileWidth > 0 && level->tileHeight > 0 &&
+            (int64_t)level->offsets.size() == tiles &&
+            (int64_t)level->byteCounts.size() == tiles;
+  return true;
+}
+
+static bool WiderLevel(const Level &a, const Level &b) {
+  return a.width > b.width;
+}
+
+static openslide_t *OpenTiff(const char *filename) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  unsigned char header[8];
+  if (!ReadAt(fd, 0, header, 8) || header[0] != 'I' || header[1] != 'I' ||
+      U16(header + 2) != 42) {
+    close(fd);
+    return NULL;
+  }
+
+  openslide_t *osr = new openslide_t;
+  osr->fd = fd;
+  osr->failed = false;
+  uint64_t offset = U32(header + 4);
+  // Bounds the walk in case the IFD chain loops
+  for (int i = 0; offset != 0 && i < 64; i++) {
+    Level level;
+    bool usable = false;
+    if (!ReadLevel(fd, offset, &level, &offset, &usable)) {
+      break;
+    }
+    if (usable) {
+      osr->levels.push_back(level);
+    }
+  }
+  if (osr->levels.empty()) {
+    close(fd);
+    delete osr;
+    return NULL;
+  }
+
+  // openslide orders levels from largest to smallest and averages the
+  // two axis ratios into the downsample
+  std::stable_sort(osr->levels.begin(), osr->levels.end(), WiderLevel);
+  const Level &base = osr->levels[0];
+  for (size_t i = 0; i < osr->levels.size(); i++) {
+    Level &level = osr->levels[i];
+    level.downsample = ((double)base.width / level.width +
+                        (double)base.height / level.height) / 2;
+    std::ostringstream prefix;
+    prefix << "openslide.level[" << i << "].";
+    std::ostringstream width, height, downsample, tileWidth, tileHeight;
+    width << level.width;
+    height << level.height;
+    downsample << level.downsample;
+    tileWidth << level.tileWidth;
+    tileHeight << level.tileHeight;
+    osr->properties[prefix.str() + "width"] = width.str();
+    osr->properties[prefix.str() + "height"] = height.str();
+    osr->properties[prefix.str() + "downsample"] = downsample.str();
+    osr->properties[prefix.str() + "tile-width"] = tileWidth.str();
+    osr->properties[prefix.str() + "tile-height"] = tileHeight.str();
+  }
+  std::ostringstream levelCount;
+  levelCount << osr->levels.size();
+  osr->properties["openslide.level-count"] = levelCount.str();
+  osr->properties["openslide.vendor"] = "generic-tiff";
+  for (std::map<std::string,std::string>::const_iterator it = osr->properties.begin();
+       it != osr->properties.end(); ++it) {
+    osr->propertyNames.push_back(it->first.c_str());
+  }
+  osr->propertyNames.push_back(NULL);
+  return osr;
+}
+
+static void SetError(openslide_t *osr, const std::string &error) {
+  if (!osr->failed) {
+    osr->error = error;
+    osr->failed = true;
+  }
+}
+
+// Decodes one tile into RGB bytes, tileWidth * tileHeight * 3 of them
+static bool ReadTile(openslide_t *osr, const Level &level, size_t index,
+                     std::vector<unsigned char> *rgb) {
+  std::vector<unsigned char> data(level.byteCounts[index]);
+  if (data.empty() || !ReadAt(osr->fd, level.offsets[index], &data[0], data.size())) {
+    SetError(osr, "Cannot read TIFF tile");
+    return false;
+  }
+  rgb->resize(level.tileWidth * level.tileHeight * 3);
+  if (level.compression == COMPRESSION_NONE) {
+    memcpy(&(*rgb)[0], &data[0], std::min(data.size(), rgb->size()));
+    return true;
+  }
+  uLongf size = rgb->size();
+  if (uncompress(&(*rgb)[0], &size, &data[0], data.size()) != Z_OK) {
+    SetError(osr, "Cannot inflate TIFF tile");
+    return false;
+  }
+  return true;
+}
+
+extern "C" {
+
+const char *openslide_detect_vendor(const char *filename) {
+  openslide_t *osr = OpenTiff(filename);
+  if (osr == NULL) {
+    return NULL;
+  }
+  close(osr->fd);
+  delete osr;
+  return "generic-tiff";
+}
+
+openslide_t *openslide_open(const char *filename) {
+  openslide_t *osr = OpenTiff(filename);
+  if (osr != NULL) {
+    int64_t open = ++openHandles;
+    int64_t peak = peakHandles;
+    while (open > peak && !peakHandles.compare_exchange_weak(peak, open)) {
+    }
+  }
+  return osr;
+}
+
+void openslide_close(openslide_t *osr) {
+  openHandles--;
+  close(osr->fd);
+  delete osr;
+}
+
+int32_t openslide_get_level_count(openslide_t *osr) {
+  return osr->failed ? -1 : (int32_t)osr->levels.size();
+}
+
+void openslide_get_level_dimensions(openslide_t *osr, int32_t level, int64_t *w, int64_t *h) {
+  if (osr->failed || level < 0 || level >= (int32_t)osr->levels.size()) {
+    *w = -1;
+    *h = -1;
+    return;
+  }
+  *w = osr->levels[level].width;
+  *h = osr->levels[level].height;
+}
+
+double openslide_get_level_downsample(openslide_t *osr, int32_t level) {
+  if (osr->failed || level < 0 || level >= (int32_t)osr->levels.size()) {
+    return -1.0;
+  }
+  return osr->levels[level].downsample;
+}
+
+int32_t openslide_get_best_level_for_downsample(openslide_t *osr, double downsample) {
+  if (osr->failed) {
+    return -1;
+  }
+  int32_t count = (int32_t)osr->levels.size();
+  for (int32_t i = 1; i < count; i++) {
+    if (downsample < osr->levels[i].downsample) {
+      return i - 1;
+    }
+  }
+  return count - 1;
+}
+
+// Pixels outside the level come back transparent, as in openslide
+void openslide_read_region(openslide_t *osr, uint32_t *dest,
+                           int64_t x, int64_t y, int32_t level, int64_t w, int64_t h) {
+  if (w <= 0 || h <= 0) {
+    return;
+  }
+  memset(dest, 0, w * h * 4);
+  if (osr->failed) {
+    return;
+  }
+  if (level < 0 || level >= (int32_t)osr->levels.size()) {
+    SetError(osr, "Invalid level");
+    return;
+  }
+  const Level &l = osr->levels[level];
+  int64_t lX = (int64_t)(x / l.downsample);
+  int64_t lY = (int64_t)(y / l.downsample);
+  int64_t x0 = std::max(lX, (int64_t)0);
+  int64_t y0 = std::max(lY, (int64_t)0);
+  int64_t x1 = std::min(lX + w, l.width);
+  int64_t y1 = std::min(lY + h, l.height);
+  if (x0 >= x1 || y0 >= y1) {
+    return;
+  }
+
+  int64_t columns = (l.width + l.tileWidth - 1) / l.tileWidth;
+  std::vector<unsigned char> rgb;
+  for (int64_t row = y0 / l.tileHeight; row <= (y1 - 1) / l.tileHeight; row++) {
+    for (int64_t col = x0 / l.tileWidth; col <= (x1 - 1) / l.tileWidth; col++) {
+      if (!ReadTile(osr, l, row * columns + col, &rgb)) {
+        memset(dest, 0, w * h * 4);
+        return;
+      }
+      int64_t tileX = col * l.tileWidth;
+      int64_t tileY = row * l.tileHeight;
+      int64_t fromX = std::max(x0, tileX);
+      int64_t toX = std::min(x1, tileX + l.tileWidth);
+      for (int64_t py = std::max(y0, tileY); py < std::min(y1, tileY + l.tileHeight); py++) {
+        const unsigned char *src = &rgb[((py - tileY) * l.tileWidth + (fromX - tileX)) * 3];
+        uint32_t *out = dest + (py - lY) * w + (fromX - lX);
+        for (int64_t px = fromX; px < toX; px++, src += 3) {
+          *out++ = 0xff000000u | ((uint32_t)src[0] << 16) | ((uint32_t)src[1] << 8) | src[2];
+        }
+      }
+    }
+  }
+}
+
+const char *openslide_get_error(openslide_t *osr) {
+  return osr->failed ? osr->error.c_str() : NULL;
+}
+
+const char * const *openslide_get_property_names(openslide_t *osr) {
+  return &osr->propertyNames[0];
+}
+
+const char *openslide_get_property_value(openslide_t *osr, const char *name) {
+  std::map<std::string,std::string>::const_iterator it = osr->properties.find(name);
+  return it == osr->properties.end() ? NULL : it->second.c_str();
+}
+
+// Plain TIFFs have no associated images
+const char * const *openslide_get_associated_image_names(openslide_t *osr) {
+  static const char * const none[] = { NULL };
+  return none;
+}
+
+void openslide_get_associated_image_dimensions(openslide_t *osr, const char *name,
+                                               int64_t *w, int64_t *h) {
+  *w = -1;
+  *h = -1;
+}
+
+void openslide_read_associated_image(openslide_t *osr, const char *name, uint32_t *dest) {
+  SetError(osr, "No associated images");
+}
+
+}
@@ -0,0 +1,37 @@
+#ifndef OPENSLIDE_STANDIN_H
+#define OPENSLIDE_STANDIN_H
+
+// The subset of the openslide 3.4 API the addon uses, implemented by
+// test/standin/openslide.cc for machines without openslide installed.
+// Only tiled, 8-bit RGB TIFFs such as bench/tiff.js writes can be opened.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _openslide openslide_t;
+
+const char *openslide_detect_vendor(const char *filename);
+openslide_t *openslide_open(const char *filename);
+void openslide_close(openslide_t *osr);
+int32_t openslide_get_level_count(openslide_t *osr);
+void openslide_get_level_dimensions(openslide_t *osr, int32_t level, int64_t *w, int64_t *h);
+double openslide_get_level_downsample(openslide_t *osr, int32_t level);
+int32_t openslide_get_best_level_for_downsample(openslide_t *osr, double downsample);
+void openslide_read_region(openslide_t *osr, uint32_t *dest,
+                           int64_t x, int64_t y, int32_t level, int64_t w, int64_t h);
+const char *openslide_get_error(openslide_t *osr);
+const char * const *openslide_get_property_names(openslide_t *osr);
+const char *openslide_get_property_value(openslide_t *osr, const char *name);
+const char * const *openslide_get_associated_image_names(openslide_t *osr);
+void openslide_get_associated_image_dimensions(openslide_t *osr, const char *name,
+                                               int64_t *w, int64_t *h);
+void openslide_read_associated_image(openslide_t *osr, const char *name, uint32_t *dest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
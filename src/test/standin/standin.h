@@ -0,0 +1,12 @@
+#ifndef STANDIN_H
+#define STANDIN_H
+
+#include <stdint.h>
+
+// Handles the stand-in openslide has open right now, and the most it
+// had open at once since the last ResetPeakHandles
+int64_t StandinOpenHandles();
+int64_t StandinPeakHandles();
+void StandinResetPeakHandles();
+
+#endif
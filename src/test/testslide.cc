@@ -0,0 +1,156 @@
+#include "testslide.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <sstream>
+#include <vector>
+
+uint32_t TestSlidePixel(int32_t level, int64_t x, int64_t y) {
+  uint32_t r = (uint32_t)(x * 7 + level * 64) & 0xff;
+  uint32_t g = (uint32_t)(y * 5) & 0xff;
+  uint32_t b = (uint32_t)((x ^ y) + level * 32) & 0xff;
+  return 0xff000000u | (r << 16) | (g << 8) | b;
+}
+
+std::string TestSlidePath(const char *name) {
+  const char *directory = getenv("TMPDIR");
+  std::ostringstream path;
+  path << (directory != NULL ? directory : "/tmp") << "/openslide-test-" << getpid() << "-"
+       << name << ".tiff";
+  return path.str();
+}
+
+static void Put16(std::vector<unsigned char> *out, uint32_t value) {
+  out->push_back(value & 0xff);
+  out->push_back((value >> 8) & 0xff);
+}
+
+static void Put32(std::vector<unsigned char> *out, uint32_t value) {
+  Put16(out, value & 0xffff);
+  Put16(out, value >> 16);
+}
+
+struct Entry {
+  uint16_t tag;
+  uint16_t type;
+  std::vector<uint32_t> values;
+};
+
+static Entry Short(uint16_t tag, uint32_t value) {
+  Entry entry = { tag, 3, std::vector<uint32_t>(1, value) };
+  return entry;
+}
+
+static Entry Long(uint16_t tag, const std::vector<uint32_t> &values) {
+  Entry entry = { tag, 4, values };
+  return entry;
+}
+
+// Appends an IFD at the end of file, with out-of-line values after it,
+// links it from nextPointer and returns where its own next pointer is
+static size_t AppendIfd(std::vector<unsigned char> *file, const std::vector<Entry> &entries,
+                      size_t nextPointer) {
+  if (file->size() % 2) {
+    file->push_back(0);
+  }
+  uint32_t offset = file->size();
+  (*file)[nextPointer] = offset & 0xff;
+  (*file)[nextPointer + 1] = (offset >> 8) & 0xff;
+  (*file)[nextPointer + 2] = (offset >> 16) & 0xff;
+  (*file)[nextPointer + 3] = offset >> 24;
+
+  uint32_t extra = offset + 2 + entries.size() * 12 + 4;
+  std::vector<unsigned char> values;
+  Put16(file, entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    const Entry &entry = entries[i];
+    Put16(file, entry.tag);
+    Put16(file, entry.type);
+    Put32(file, entry.values.size());
+    size_t itemSize = entry.type == 3 ? 2 : 4;
+    std::vector<unsigned char> data;
+    for (size_t k = 0; k < entry.values.size(); k++) {
+      if (itemSize == 2) {
+        Put16(&data, entry.values[k]);
+      } else {
+        Put32(&data, entry.values[k]);
+      }
+    }
+    if (data.size() <= 4) {
+      data.resize(4, 0);
+      file->insert(file->end(), data.begin(), data.end());
+    } else {
+      Put32(file, extra + values.size());
+      values.insert(values.end(), data.begin(), data.end());
+    }
+  }
+  size_t next = file->size();
+  Put32(file, 0);
+  file->insert(file->end(), values.begin(), values.end());
+  return next;
+}
+
+bool WriteTestSlide(const std::string &path, int64_t width, int64_t height, int64_t tileSize,
+                    int32_t maxLevels) {
+  std::vector<unsigned char> file;
+  file.push_back('I');
+  file.push_back('I');
+  Put16(&file, 42);
+  Put32(&file, 0);
+  size_t nextPointer = 4;
+
+  int64_t w = width, h = height;
+  for (int32_t level = 0; ; level++) {
+    int64_t columns = (w + tileSize - 1) / tileSize;
+    int64_t rows = (h + tileSize - 1) / tileSize;
+    std::vector<uint32_t> offsets, counts;
+    std::vector<unsigned char> rgb(tileSize * tileSize * 3);
+    for (int64_t row = 0; row < rows; row++) {
+      for (int64_t col = 0; col < columns; col++) {
+        for (int64_t y = 0; y < tileSize; y++) {
+          for (int64_t x = 0; x < tileSize; x++) {
+            uint32_t pixel = TestSlidePixel(level, col * tileSize + x, row * tileSize + y);
+            unsigned char *out = &rgb[(y * tileSize + x) * 3];
+            out[0] = (pixel >> 16) & 0xff;
+            out[1] = (pixel >> 8) & 0xff;
+            out[2] = pixel & 0xff;
+          }
+        }
+        uLongf size = compressBound(rgb.size());
+        std::vector<unsigned char> compressed(size);
+        compress2(&compressed[0], &size, &rgb[0], rgb.size(), 1);
+        offsets.push_back(file.size());
+        counts.push_back(size);
+        file.insert(file.end(), compressed.begin(), compressed.begin() + size);
+      }
+    }
+
+    std::vector<Entry> entries;
+    entries.push_back(Long(256, std::vector<uint32_t>(1, w)));
+    entries.push_back(Long(257, std::vector<uint32_t>(1, h)));
+    entries.push_back(Short(258, 8));
+    entries.push_back(Short(259, 8));
+    entries.push_back(Short(262, 2));
+    entries.push_back(Short(277, 3));
+    entries.push_back(Short(284, 1));
+    entries.push_back(Long(322, std::vector<uint32_t>(1, tileSize)));
+    entries.push_back(Long(323, std::vector<uint32_t>(1, tileSize)));
+    entries.push_back(Long(324, offsets));
+    entries.push_back(Long(325, counts));
+    nextPointer = AppendIfd(&file, entries, nextPointer);
+
+    if ((w <= tileSize && h <= tileSize) || level + 1 == maxLevels) {
+      break;
+    }
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+  }
+
+  FILE *out = fopen(path.c_str(), "wb");
+  if (out == NULL) {
+    return false;
+  }
+  bool written = fwrite(&file[0], 1, file.size(), out) == file.size();
+  return fclose(out) == 0 && written;
+}
@@ -0,0 +1,20 @@
+#ifndef TESTSLIDE_H
+#define TESTSLIDE_H
+
+#include <stdint.h>
+#include <string>
+
+// Writes a pyramidal tiled TIFF the stand-in openslide can open: each
+// level half the size of the previous one, down to a single tile or
+// maxLevels levels if that is not 0, with deflate-compressed RGB tiles.
+// Returns false if the file cannot be written.
+bool WriteTestSlide(const std::string &path, int64_t width, int64_t height, int64_t tileSize,
+                    int32_t maxLevels = 0);
+
+// The opaque ARGB pixel WriteTestSlide stores at (x, y) of level
+uint32_t TestSlidePixel(int32_t level, int64_t x, int64_t y);
+
+// A path under the temp directory that is unique to this process
+std::string TestSlidePath(const char *name);
+
+#endif
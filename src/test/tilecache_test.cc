@@ -0,0 +1,108 @@
+#include "check.h"
+#include "tilecache.h"
+#include <string.h>
+#include <vector>
+
+static TileKey Key(int64_t x) {
+  EncodeOptions raw;
+  DefaultEncodeOptions(&raw);
+  return RegionTileKey("slide.tiff", 0, x, 0, 32, 32, raw);
+}
+
+static void CheckStats(TileCache *cache, uint64_t hits, uint64_t misses, uint64_t insertions) {
+  TileCacheStats stats;
+  cache->GetStats(&stats);
+  CHECK(stats.hits == hits);
+  CHECK(stats.misses == misses);
+  CHECK(stats.insertions == insertions);
+}
+
+int main() {
+  std::vector<char> tile(4096);
+  for (size_t i = 0; i < tile.size(); i++) {
+    tile[i] = (char)i;
+  }
+
+  // Hits return a copy of what was put, misses nothing
+  {
+    TileCache cache(16 * 1024 * 1024);
+    CHECK(!cache.Get(Key(0)));
+    cache.Put(Key(0), &tile[0], tile.size());
+    TileData data = cache.Get(Key(0));
+    CHECK(data && data->size() == tile.size() && memcmp(&(*data)[0], &tile[0], tile.size()) == 0);
+    // A second put of the same key keeps the first entry
+    cache.Put(Key(0), &tile[0], 16);
+    CHECK(cache.Get(Key(0))->size() == tile.size());
+    CheckStats(&cache, 2, 1, 1);
+  }
+
+  // The budget holds: old entries are evicted, recent ones stay
+  {
+    size_t maxBytes = 256 * 1024;
+    TileCache cache(maxBytes);
+    for (int64_t i = 0; i < 1000; i++) {
+      cache.Put(Key(i), &tile[0], tile.size());
+    }
+    TileCacheStats stats;
+    cache.GetStats(&stats);
+    CHECK(stats.bytes <= maxBytes);
+    CHECK(stats.entries > 0 && stats.entries < 1000);
+    CHECK(stats.insertions == 1000);
+    CHECK(stats.evictions == 1000 - stats.entries);
+    CHECK(stats.maxBytes == maxBytes);
+    CHECK(cache.Get(Key(999)));
+    CHECK(!cache.Get(Key(0)));
+
+    // A hit moves an entry to the front of its shard
+    cache.Clear();
+    cache.Put(Key(0), &tile[0], tile.size());
+    for (int64_t i = 1; i < 1000; i++) {
+      CHECK(cache.Get(Key(0)));
+      cache.Put(Key(i), &tile[0], tile.size());
+    }
+    CHECK(cache.Get(Key(0)));
+
+    // Entries too large for a shard are not cached at all
+    std::vector<char> large(maxBytes / 8);
+    cache.Put(Key(-1), &large[0], large.size());
+    CHECK(!cache.Get(Key(-1)));
+
+    cache.SetMaxBytes(0);
+    cache.GetStats(&stats);
+    CHECK(stats.entries == 0 && stats.bytes == 0);
+    cache.Put(Key(1), &tile[0], tile.size());
+    CHECK(!cache.Get(Key(1)));
+  }
+
+  // Raw entries are opt-in
+  {
+    TileCache cache(1024 * 1024);
+    CHECK(!cache.CacheRaw());
+    cache.SetCacheRaw(true);
+    CHECK(cache.CacheRaw());
+  }
+
+  // Keys differ in every field that changes the bytes
+  {
+    EncodeOptions raw, jpeg, jpeg90;
+    DefaultEncodeOptions(&raw);
+    jpeg = raw;
+    jpeg.format = FORMAT_JPEG;
+    jpeg90 = jpeg;
+    jpeg90.quality = 90;
+    TileKey region = RegionTileKey("a", 0, 0, 0, 256, 256, raw);
+    CHECK(!(region == RegionTileKey("b", 0, 0, 0, 256, 256, raw)));
+    CHECK(!(region == RegionTileKey("a", 1, 0, 0, 256, 256, raw)));
+    CHECK(!(region == RegionTileKey("a", 0, 0, 0, 256, 255, raw)));
+    CHECK(!(region == RegionTileKey("a", 0, 0, 0, 256, 256, jpeg)));
+    CHECK(!(RegionTileKey("a", 0, 0, 0, 256, 256, jpeg) ==
+            RegionTileKey("a", 0, 0, 0, 256, 256, jpeg90)));
+    CHECK(!(DeepZoomTileKey("a", 254, 1, false, 10, 0, 0, raw) ==
+            DeepZoomTileKey("a", 254, 1, true, 10, 0, 0, raw)));
+    CHECK(!(DeepZoomTileKey("a", 254, 1 << 20, false, 10, 0, 0, raw) ==
+            DeepZoomTileKey("a", 255, 0, false, 10, 0, 0, raw)));
+    CHECK(!(DeepZoomTileKey("a", 256, 0, false, 0, 0, 0, raw) ==
+            RegionTileKey("a", 256, 0, 0, 0, 0, raw)));
+  }
+  return TestResult("tilecache_test");
+}
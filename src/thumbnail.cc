@@ -0,0 +1,51 @@
+#include "thumbnail.h"
+#include "regionreader.h"
+#include <math.h>
+#include <algorithm>
+
+void GetThumbnailSize(const Slide &slide, int64_t maxW, int64_t maxH, int64_t *w, int64_t *h) {
+  int64_t l0W = slide.levelWidths[0];
+  int64_t l0H = slide.levelHeights[0];
+  double scale = std::min(std::min((double)maxW / l0W, (double)maxH / l0H), 1.0);
+  *w = std::max((int64_t)1, (int64_t)floor(l0W * scale + 0.5));
+  *h = std::max((int64_t)1, (int64_t)floor(l0H * scale + 0.5));
+}
+
+bool ReadThumbnail(Slide *slide, int64_t w, int64_t h, uint32_t *dest, std::string *error) {
+  double downsample = std::max((double)slide->levelWidths[0] / w,
+                               (double)slide->levelHeights[0] / h);
+  int32_t level = slide->BestLevelForDownsample(downsample);
+  int64_t lW = slide->levelWidths[level];
+  int64_t lH = slide->levelHeights[level];
+  if (lW == w && lH == h) {
+    return ReadRegionTiled(slide, dest, 0, 0, level, lW, lH, error);
+  }
+
+  // The level can be far larger than the thumbnail, so it is never held
+  // whole: each band only needs its own source rows
+  return ReadRegionScaled(slide, dest, 0, 0, level, lW, lH, w, h, error);
+}
+
+bool ReadAssociatedImage(Slide *slide, const std::string &name, uint32_t *dest,
+                         std::string *error) {
+  openslide_t *osr = slide->handles.Acquire();
+  if (osr == NULL) {
+    *error = "Cannot open slide";
+    return false;
+  }
+  uint64_t start = NowMicros();
+  openslide_read_associated_image(osr, name.c_str(), dest);
+  uint64_t micros = NowMicros() - start;
+  std::map<std::string,std::pair<int64_t,int64_t> >::const_iterator it =
+    slide->associatedImages.find(name);
+  if (it != slide->associatedImages.end()) {
+    slide->stats->RecordDecode(micros, it->second.first * it->second.second);
+  }
+  const char *openslideError = openslide_get_error(osr);
+  bool ok = openslideError == NULL;
+  if (!ok) {
+    *error = openslideError;
+  }
+  slide->handles.Release(osr);
+  return ok;
+}
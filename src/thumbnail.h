@@ -0,0 +1,21 @@
+#ifndef THUMBNAIL_H
+#define THUMBNAIL_H
+
+#include <stdint.h>
+#include <string>
+#include "slide.h"
+
+// Size of a thumbnail fitting in maxW x maxH, keeping the slide's aspect
+// ratio and never larger than level 0
+void GetThumbnailSize(const Slide &slide, int64_t maxW, int64_t maxH, int64_t *w, int64_t *h);
+
+// Renders the whole slide at w x h: reads the closest level in bands,
+// in parallel, scaling each into dest with an area filter as it arrives.
+// Only the thumbnail itself has to fit in memory, not the level.
+bool ReadThumbnail(Slide *slide, int64_t w, int64_t h, uint32_t *dest, std::string *error);
+
+// Reads a named associated image, whose size is in slide.associatedImages
+bool ReadAssociatedImage(Slide *slide, const std::string &name, uint32_t *dest,
+                         std::string *error);
+
+#endif
@@ -0,0 +1,167 @@
+#include "tilecache.h"
+#include <stdlib.h>
+#include <string.h>
+
+TileCache tileCache(128 * 1024 * 1024);
+
+// Bookkeeping charged per entry on top of the data itself
+static const size_t ENTRY_OVERHEAD = 128;
+
+enum TileKind {
+  KIND_REGION,
+  KIND_DEEPZOOM
+};
+
+static void SetEncoding(TileKey *key, const EncodeOptions &options) {
+  key->values[6] = options.format;
+  key->values[7] = options.format == FORMAT_JPEG ? options.quality : 0;
+  key->values[8] = options.format == FORMAT_RAW ? -1 :
+                   (options.hasBackground || options.format == FORMAT_JPEG ? options.background : -1);
+}
+
+TileKey RegionTileKey(const std::string &slide, int32_t level, int64_t x, int64_t y,
+                      int64_t w, int64_t h, const EncodeOptions &options) {
+  TileKey key;
+  key.slide = slide;
+  key.values[0] = KIND_REGION;
+  key.values[1] = level;
+  key.values[2] = x;
+  key.values[3] = y;
+  key.values[4] = w;
+  key.values[5] = h;
+  SetEncoding(&key, options);
+  return key;
+}
+
+TileKey DeepZoomTileKey(const std::string &slide, int tileSize, int overlap, bool limitBounds,
+                        int level, int64_t col, int64_t row, const EncodeOptions &options) {
+  TileKey key;
+  key.slide = slide;
+  key.values[0] = KIND_DEEPZOOM;
+  key.values[1] = tileSize;
+  // overlap is an int, so shifting it within an int64_t loses nothing
+  key.values[2] = ((int64_t)overlap << 1) | (limitBounds ? 1 : 0);
+  key.values[3] = level;
+  key.values[4] = col;
+  key.values[5] = row;
+  SetEncoding(&key, options);
+  return key;
+}
+
+bool TileKey::operator==(const TileKey &other) const {
+  return memcmp(values, other.values, sizeof(values)) == 0 && slide == other.slide;
+}
+
+size_t TileKeyHash::operator()(const TileKey &key) const {
+  size_t hash = std::hash<std::string>()(key.slide);
+  for (size_t i = 0; i < sizeof(key.values) / sizeof(key.values[0]); i++) {
+    hash ^= std::hash<int64_t>()(key.values[i]) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
+char *CopyTileData(const TileData &data) {
+  char *copy = (char *)malloc(data->size());
+  if (copy != NULL) {
+    memcpy(copy, &(*data)[0], data->size());
+  }
+  return copy;
+}
+
+TileCache::TileCache(size_t maxBytes)
+  : _maxBytes(maxBytes), _cacheRaw(false), _hits(0), _misses(0), _insertions(0),
+    _evictions(0) {
+  for (size_t i = 0; i < SHARD_COUNT; i++) {
+    _shards[i].bytes = 0;
+  }
+}
+
+TileCache::Shard &TileCache::ShardFor(const TileKey &key) {
+  // The low bits feed the hash map buckets, pick the shard from the top
+  size_t hash = TileKeyHash()(key);
+  return _shards[(hash >> 16) % SHARD_COUNT];
+}
+
+TileData TileCache::Get(const TileKey &key) {
+  Shard &shard = ShardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  std::unordered_map<TileKey,EntryList::iterator,TileKeyHash>::iterator it = shard.index.find(key);
+  if (it == shard.index.end()) {
+    _misses++;
+    return TileData();
+  }
+  shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+  _hits++;
+  return it->second->data;
+}
+
+void TileCache::Put(const TileKey &key, const char *data, size_t size) {
+  size_t shardBytes = _maxBytes / SHARD_COUNT;
+  size_t entrySize = size + key.slide.size() + ENTRY_OVERHEAD;
+  if (entrySize > shardBytes) {
+    return;
+  }
+  // Copy before taking the lock
+  TileData copy = std::make_shared<const std::vector<char> >(data, data + size);
+
+  Shard &shard = ShardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  std::unordered_map<TileKey,EntryList::iterator,TileKeyHash>::iterator it = shard.index.find(key);
+  if (it != shard.index.end()) {
+    // Decoded concurrently by another worker, keep the existing entry
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return;
+  }
+  Entry entry = { key, copy, entrySize };
+  shard.lru.push_front(entry);
+  shard.index[key] = shard.lru.begin();
+  shard.bytes += entrySize;
+  _insertions++;
+  Evict(shard, shardBytes);
+}
+
+void TileCache::Evict(Shard &shard, size_t maxBytes) {
+  while (shard.bytes > maxBytes && !shard.lru.empty()) {
+    Entry &entry = shard.lru.back();
+    shard.bytes -= entry.size;
+    shard.index.erase(entry.key);
+    shard.lru.pop_back();
+    _evictions++;
+  }
+}
+
+void TileCache::SetMaxBytes(size_t maxBytes) {
+  _maxBytes = maxBytes;
+  for (size_t i = 0; i < SHARD_COUNT; i++) {
+    std::lock_guard<std::mutex> lock(_shards[i].mutex);
+    Evict(_shards[i], maxBytes / SHARD_COUNT);
+  }
+}
+
+void TileCache::SetCacheRaw(bool cacheRaw) {
+  _cacheRaw = cacheRaw;
+}
+
+void TileCache::Clear() {
+  for (size_t i = 0; i < SHARD_COUNT; i++) {
+    std::lock_guard<std::mutex> lock(_shards[i].mutex);
+    _shards[i].lru.clear();
+    _shards[i].index.clear();
+    _shards[i].bytes = 0;
+  }
+}
+
+void TileCache::GetStats(TileCacheStats *stats) {
+  stats->hits = _hits;
+  stats->misses = _misses;
+  stats->insertions = _insertions;
+  stats->evictions = _evictions;
+  stats->entries = 0;
+  stats->bytes = 0;
+  stats->maxBytes = _maxBytes;
+  for (size_t i = 0; i < SHARD_COUNT; i++) {
+    std::lock_guard<std::mutex> lock(_shards[i].mutex);
+    stats->entries += _shards[i].index.size();
+    stats->bytes += _shards[i].bytes;
+  }
+}
@@ -0,0 +1,95 @@
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "encoder.h"
+
+// Identifies a cached tile: the slide path plus what was read and how
+// it was encoded
+struct TileKey {
+  std::string slide;
+  int64_t values[9];
+  bool operator==(const TileKey &other) const;
+};
+
+struct TileKeyHash {
+  size_t operator()(const TileKey &key) const;
+};
+
+// A region read with openslide_read_region
+TileKey RegionTileKey(const std::string &slide, int32_t level, int64_t x, int64_t y,
+                      int64_t w, int64_t h, const EncodeOptions &options);
+// A tile from a Deep Zoom generator
+TileKey DeepZoomTileKey(const std::string &slide, int tileSize, int overlap, bool limitBounds,
+                        int level, int64_t col, int64_t row, const EncodeOptions &options);
+
+struct TileCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t insertions;
+  uint64_t evictions;
+  size_t entries;
+  size_t bytes;
+  size_t maxBytes;
+};
+
+typedef std::shared_ptr<const std::vector<char> > TileData;
+
+// malloc'ed copy of a cache entry, for handing to Nan::NewBuffer
+char *CopyTileData(const TileData &data);
+
+// Byte-budgeted LRU cache of decoded or encoded tiles, shared by every
+// slide. Keys are spread over independently locked shards, each with an
+// equal part of the budget, so concurrent workers rarely contend.
+// Entries are immutable; readers copy them out after Get returns.
+class TileCache {
+    public:
+        explicit TileCache(size_t maxBytes);
+        // Empty if not cached. Counts a hit or a miss.
+        TileData Get(const TileKey &key);
+        void Put(const TileKey &key, const char *data, size_t size);
+        // Shrinking evicts immediately, 0 disables caching
+        void SetMaxBytes(size_t maxBytes);
+        // Whether raw ARGB regions and tiles are cached, off by default:
+        // they are large and every miss copies one in, while decoding
+        // them again is cheap next to decoding and re-encoding. Callers
+        // check this before Get and Put of raw entries.
+        void SetCacheRaw(bool cacheRaw);
+        bool CacheRaw() const { return _cacheRaw; }
+        void Clear();
+        void GetStats(TileCacheStats *stats);
+    private:
+        static const size_t SHARD_COUNT = 16;
+        struct Entry {
+            TileKey key;
+            TileData data;
+            size_t size;
+        };
+        typedef std::list<Entry> EntryList;
+        struct Shard {
+            std::mutex mutex;
+            EntryList lru;
+            std::unordered_map<TileKey,EntryList::iterator,TileKeyHash> index;
+            size_t bytes;
+        };
+        Shard &ShardFor(const TileKey &key);
+        void Evict(Shard &shard, size_t maxBytes);
+        Shard _shards[SHARD_COUNT];
+        std::atomic<size_t> _maxBytes;
+        std::atomic<bool> _cacheRaw;
+        std::atomic<uint64_t> _hits;
+        std::atomic<uint64_t> _misses;
+        std::atomic<uint64_t> _insertions;
+        std::atomic<uint64_t> _evictions;
+};
+
+extern TileCache tileCache;
+
+#endif